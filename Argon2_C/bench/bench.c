@@ -0,0 +1,350 @@
+/*
+ * Argon2 reference source code package - reference C implementations
+ *
+ * Copyright 2015
+ * Daniel Dinu, Dmitry Khovratovich, Jean-Philippe Aumasson, and Samuel Neves
+ *
+ * You may use this work under the terms of a Creative Commons CC0 1.0
+ * License/Waiver or the Apache Public License 2.0, at your option. The terms of
+ * these licenses can be found at:
+ *
+ * - CC0 1.0 Universal : http://creativecommons.org/publicdomain/zero/1.0
+ * - Apache 2.0        : http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * You should have received a copy of both of these licenses along with this
+ * software. If not, they may be obtained at the above URLs.
+ */
+
+/*
+ * Throughput and latency benchmark for the parameter sets Ixian hashes with:
+ * block v0 solutions (t=1, m=1024, p=4) and v1/v2 mining and verification
+ * (t=1, m=1024, p=2). Every combination of parameter set, fill_block kernel,
+ * caller thread count and memory mode runs for a fixed time; the results are
+ * printed to stdout as one JSON document.
+ *
+ * Usage: argon2_bench [-s seconds per case] [-t max threads] [-k kernel]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "argon2.h"
+
+#define BENCH_HASH_LENGTH 32
+#define BENCH_CHALLENGE_LENGTH 68 /* block checksum + solver address */
+#define BENCH_NONCE_LENGTH 32
+#define BENCH_MAX_THREADS 256
+#define BENCH_MAX_SAMPLES (1 << 20)
+
+typedef struct bench_params {
+    const char *name;
+    uint32_t t_cost;
+    uint32_t m_cost;
+    uint32_t lanes;
+} bench_params;
+
+static const bench_params param_sets[] = {
+    {"v0", 1, 1024, 4},
+    {"v1", 1, 1024, 2},
+};
+
+enum bench_mode { BENCH_MALLOC = 0, BENCH_ARENA = 1 };
+static const char *mode_names[] = {"malloc", "arena"};
+
+/* One caller thread of a benchmark case */
+typedef struct bench_worker {
+    const bench_params *params;
+    int mode;
+    uint64_t deadline_ns;
+    uint32_t index;
+    double *samples;     /* per-hash latency in microseconds */
+    size_t max_samples;
+    size_t hashes;
+    int result;
+} bench_worker;
+
+static uint64_t now_ns(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static uint32_t cpu_count(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (uint32_t)n : 1;
+#endif
+}
+
+/* Nonces are counted up from a per-thread start, like the miner does */
+static void next_nonce(uint8_t *nonce) {
+    int i;
+    for (i = BENCH_NONCE_LENGTH - 1; i > 0; i--) {
+        if (++nonce[i] != 0) {
+            break;
+        }
+    }
+}
+
+static void run_worker(bench_worker *w) {
+    uint8_t challenge[BENCH_CHALLENGE_LENGTH];
+    uint8_t nonce[BENCH_NONCE_LENGTH];
+    uint8_t hash[BENCH_HASH_LENGTH];
+    argon2_reusable_instance *instance = NULL;
+    uint64_t start, end;
+
+    memset(challenge, 0x5A, sizeof(challenge));
+    memset(nonce, 0, sizeof(nonce));
+    nonce[0] = (uint8_t)w->index;
+
+    if (w->mode == BENCH_ARENA) {
+        argon2_context params;
+        memset(&params, 0, sizeof(params));
+        params.t_cost = w->params->t_cost;
+        params.m_cost = w->params->m_cost;
+        params.lanes = w->params->lanes;
+        params.threads = w->params->lanes;
+        params.version = ARGON2_VERSION_NUMBER;
+        w->result = argon2_instance_create(&instance, &params, Argon2_id,
+                                           ARGON2_INSTANCE_FLAG_NO_WIPE);
+        if (w->result != ARGON2_OK) {
+            return;
+        }
+    }
+
+    do {
+        start = now_ns();
+        if (w->mode == BENCH_ARENA) {
+            w->result = argon2_hash_raw_with_instance(
+                instance, challenge, sizeof(challenge), nonce, sizeof(nonce),
+                hash, sizeof(hash));
+        } else {
+            w->result = argon2id_hash_raw(
+                w->params->t_cost, w->params->m_cost, w->params->lanes,
+                challenge, sizeof(challenge), nonce, sizeof(nonce), hash,
+                sizeof(hash));
+        }
+        end = now_ns();
+        if (w->result != ARGON2_OK) {
+            break;
+        }
+        if (w->hashes < w->max_samples) {
+            w->samples[w->hashes] = (double)(end - start) / 1000.0;
+        }
+        w->hashes++;
+        next_nonce(nonce);
+    } while (end < w->deadline_ns);
+
+    argon2_instance_destroy(instance);
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI worker_main(LPVOID arg) {
+    run_worker((bench_worker *)arg);
+    return 0;
+}
+#else
+static void *worker_main(void *arg) {
+    run_worker((bench_worker *)arg);
+    return NULL;
+}
+#endif
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t count, double p) {
+    size_t i;
+    if (count == 0) {
+        return 0.0;
+    }
+    i = (size_t)(p / 100.0 * (double)(count - 1) + 0.5);
+    return sorted[i];
+}
+
+/* Runs one case and prints its JSON object; returns 0 on success */
+static int run_case(const bench_params *params, argon2_kernel kernel,
+                    int mode, uint32_t threads, double seconds, int first) {
+    bench_worker workers[BENCH_MAX_THREADS];
+#if defined(_WIN32)
+    HANDLE handles[BENCH_MAX_THREADS];
+#else
+    pthread_t handles[BENCH_MAX_THREADS];
+#endif
+    size_t per_thread = BENCH_MAX_SAMPLES / threads;
+    double *samples, *merged;
+    size_t total = 0, kept = 0;
+    uint64_t start, elapsed;
+    uint32_t i;
+    int result = ARGON2_OK;
+
+    samples = malloc(sizeof(double) * per_thread * threads);
+    merged = malloc(sizeof(double) * per_thread * threads);
+    if (samples == NULL || merged == NULL) {
+        free(samples);
+        free(merged);
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+
+    start = now_ns();
+    for (i = 0; i < threads; i++) {
+        workers[i].params = params;
+        workers[i].mode = mode;
+        workers[i].deadline_ns = start + (uint64_t)(seconds * 1e9);
+        workers[i].index = i;
+        workers[i].samples = samples + (size_t)i * per_thread;
+        workers[i].max_samples = per_thread;
+        workers[i].hashes = 0;
+        workers[i].result = ARGON2_OK;
+#if defined(_WIN32)
+        handles[i] = CreateThread(NULL, 0, worker_main, &workers[i], 0, NULL);
+#else
+        pthread_create(&handles[i], NULL, worker_main, &workers[i]);
+#endif
+    }
+    for (i = 0; i < threads; i++) {
+#if defined(_WIN32)
+        WaitForSingleObject(handles[i], INFINITE);
+        CloseHandle(handles[i]);
+#else
+        pthread_join(handles[i], NULL);
+#endif
+    }
+    elapsed = now_ns() - start;
+
+    for (i = 0; i < threads; i++) {
+        size_t n = workers[i].hashes < per_thread ? workers[i].hashes
+                                                  : per_thread;
+        memcpy(merged + kept, workers[i].samples, n * sizeof(double));
+        kept += n;
+        total += workers[i].hashes;
+        if (workers[i].result != ARGON2_OK) {
+            result = workers[i].result;
+        }
+    }
+    qsort(merged, kept, sizeof(double), compare_doubles);
+
+    printf("%s    {\"params\": \"%s\", \"t_cost\": %u, \"m_cost\": %u, "
+           "\"lanes\": %u, \"kernel\": \"%s\", \"mode\": \"%s\", "
+           "\"threads\": %u, \"hashes\": %lu, \"seconds\": %.3f, "
+           "\"hashes_per_second\": %.1f, \"latency_us\": {\"min\": %.1f, "
+           "\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f}",
+           first ? "" : ",\n", params->name, params->t_cost, params->m_cost,
+           params->lanes, argon2_kernel2string(kernel), mode_names[mode],
+           threads, (unsigned long)total, (double)elapsed / 1e9,
+           (double)total * 1e9 / (double)elapsed, percentile(merged, kept, 0),
+           percentile(merged, kept, 50), percentile(merged, kept, 90),
+           percentile(merged, kept, 99), percentile(merged, kept, 100));
+    if (result != ARGON2_OK) {
+        printf(", \"error\": \"%s\"", argon2_error_message(result));
+    }
+    printf("}");
+    fflush(stdout);
+
+    free(samples);
+    free(merged);
+    return result;
+}
+
+static void usage(const char *cmd) {
+    fprintf(stderr,
+            "Usage: %s [-s seconds per case] [-t max threads] [-k kernel]\n"
+            "kernel is one of auto, ref, sse2, avx2, avx512f; all kernels "
+            "the CPU supports are measured by default\n",
+            cmd);
+}
+
+int main(int argc, char *argv[]) {
+    double seconds = 2.0;
+    uint32_t max_threads = cpu_count();
+    int only_kernel = -1;
+    argon2_kernel best = argon2_get_kernel();
+    size_t p;
+    int k, mode, first = 1, failed = 0, i;
+    uint32_t threads;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            max_threads = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            for (k = ARGON2_KERNEL_AUTO; k <= ARGON2_KERNEL_AVX512F; k++) {
+                if (strcmp(name, argon2_kernel2string((argon2_kernel)k)) ==
+                    0) {
+                    only_kernel = k == ARGON2_KERNEL_AUTO ? (int)best : k;
+                }
+            }
+            if (only_kernel < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (seconds <= 0 || max_threads == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (max_threads > BENCH_MAX_THREADS) {
+        max_threads = BENCH_MAX_THREADS;
+    }
+
+    printf("{\n  \"cpus\": %u,\n  \"best_kernel\": \"%s\",\n"
+           "  \"seconds_per_case\": %.3f,\n  \"results\": [\n",
+           cpu_count(), argon2_kernel2string(best), seconds);
+
+    for (p = 0; p < sizeof(param_sets) / sizeof(param_sets[0]); p++) {
+        for (k = ARGON2_KERNEL_REF; k <= (int)best; k++) {
+            if (only_kernel >= 0 && k != only_kernel) {
+                continue;
+            }
+            if (argon2_set_kernel((argon2_kernel)k) != ARGON2_OK) {
+                continue;
+            }
+            for (mode = BENCH_MALLOC; mode <= BENCH_ARENA; mode++) {
+                for (threads = 1; threads <= max_threads; threads++) {
+                    if (run_case(&param_sets[p], (argon2_kernel)k, mode,
+                                 threads, seconds, first) != ARGON2_OK) {
+                        failed = 1;
+                    }
+                    first = 0;
+                }
+            }
+        }
+    }
+    argon2_set_kernel(ARGON2_KERNEL_AUTO);
+
+    printf("\n  ]\n}\n");
+    argon2_pool_shutdown();
+    return failed;
+}
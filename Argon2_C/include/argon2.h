@@ -91,6 +91,35 @@ extern "C" {
 #define ARGON2_DEFAULT_FLAGS UINT32_C(0)
 #define ARGON2_FLAG_CLEAR_PASSWORD (UINT32_C(1) << 0)
 #define ARGON2_FLAG_CLEAR_SECRET (UINT32_C(1) << 1)
+/* Take the block memory straight from the OS in huge pages where possible
+ * (reserved huge pages, then transparent huge pages on Linux; large pages on
+ * Windows if the process may lock memory) instead of malloc. Ignored when an
+ * allocate_cbk is set. */
+#define ARGON2_FLAG_HUGE_PAGES (UINT32_C(1) << 2)
+
+/* Largest nonce and hash accepted by argon2_pow_search, in bytes */
+#define ARGON2_POW_MAX_NONCE_LENGTH UINT32_C(128)
+#define ARGON2_POW_MAX_HASH_LENGTH UINT32_C(64)
+
+/* Flags for argon2_pow_verify_batch */
+#define ARGON2_POW_VERIFY_DEFAULT_FLAGS UINT32_C(0)
+/* Stop handing out items once any item has failed */
+#define ARGON2_POW_VERIFY_SHORT_CIRCUIT (UINT32_C(1) << 0)
+
+/* Number of independent hashes the batch and proof-of-work functions fill in
+ * lockstep on one thread (see argon2_set_interleave). Off by default, as the
+ * gain depends on the CPU's cache latency against the kernel's speed. */
+#define ARGON2_MAX_INTERLEAVE UINT32_C(4)
+#define ARGON2_DEFAULT_INTERLEAVE UINT32_C(1)
+
+/* Flags for argon2_instance_create (default = wipe the arena, plain memory) */
+#define ARGON2_INSTANCE_DEFAULT_FLAGS UINT32_C(0)
+/* Leave the block arena as it is after each hash. Only for inputs that are not
+ * secret, such as proof-of-work challenges and nonces. */
+#define ARGON2_INSTANCE_FLAG_NO_WIPE (UINT32_C(1) << 0)
+/* Back the arena with huge pages when the OS allows it, plain pages
+ * otherwise. Ignored if the context supplies its own allocator. */
+#define ARGON2_INSTANCE_FLAG_HUGE_PAGES (UINT32_C(1) << 1)
 
 /* Global flag to determine if we are wiping internal memory buffers. This flag
  * is defined in core.c and deafults to 1 (wipe internal memory). */
@@ -154,7 +183,11 @@ typedef enum Argon2_ErrorCodes {
 
     ARGON2_DECODING_LENGTH_FAIL = -34,
 
-    ARGON2_VERIFY_MISMATCH = -35
+    ARGON2_VERIFY_MISMATCH = -35,
+
+    ARGON2_POW_NOT_FOUND = -36,
+
+    ARGON2_KERNEL_UNSUPPORTED = -37
 } argon2_error_codes;
 
 /* Memory allocator types --- for external allocation */
@@ -231,6 +264,15 @@ typedef enum Argon2_version {
     ARGON2_VERSION_NUMBER = ARGON2_VERSION_13
 } argon2_version;
 
+/* fill_block implementation used for hashing */
+typedef enum Argon2_kernel {
+    ARGON2_KERNEL_AUTO = 0, /* best kernel the CPU supports */
+    ARGON2_KERNEL_REF = 1,  /* portable C */
+    ARGON2_KERNEL_SSE2 = 2,
+    ARGON2_KERNEL_AVX2 = 3,
+    ARGON2_KERNEL_AVX512F = 4
+} argon2_kernel;
+
 /*
  * Function that gives the string representation of an argon2_type.
  * @param type The argon2_type that we want the string for
@@ -327,6 +369,199 @@ ARGON2_PUBLIC int argon2_hash(const uint32_t t_cost, const uint32_t m_cost,
                               const size_t encodedlen, argon2_type type,
                               const uint32_t version);
 
+/* One piece of a password passed as scatter/gather input */
+typedef struct Argon2_segment {
+    const void *data; /* may be NULL only if len is 0 */
+    size_t len;
+} argon2_segment;
+
+/**
+ * Hashes a password given as @count segments, read in order as if they were
+ * concatenated, into a raw hash written straight to @hash. For callers that
+ * pin their own buffers: apart from the block arena nothing is allocated and
+ * no input is copied, so e.g. a challenge and a solver address need not be
+ * joined first.
+ * @param t_cost Number of iterations
+ * @param m_cost Sets memory usage to m_cost kibibytes
+ * @param parallelism Number of threads and compute lanes
+ * @param segments @count password segments
+ * @param count Number of segments, may be 0 for an empty password
+ * @param salt Pointer to salt
+ * @param saltlen Salt size in bytes
+ * @param hash Buffer receiving the raw hash
+ * @param hashlen Desired length of the hash in bytes
+ * @pre   The hash equals the one argon2_hash gives for the joined password
+ * @pre   Returns ARGON2_OK if successful
+ */
+ARGON2_PUBLIC int argon2id_hash_raw_segments(const uint32_t t_cost,
+                                             const uint32_t m_cost,
+                                             const uint32_t parallelism,
+                                             const argon2_segment *segments,
+                                             const size_t count,
+                                             const void *salt,
+                                             const size_t saltlen, void *hash,
+                                             const size_t hashlen);
+
+/* generic function underlying the above one */
+ARGON2_PUBLIC int argon2_hash_raw_segments(const uint32_t t_cost,
+                                           const uint32_t m_cost,
+                                           const uint32_t parallelism,
+                                           const argon2_segment *segments,
+                                           const size_t count,
+                                           const void *salt,
+                                           const size_t saltlen, void *hash,
+                                           const size_t hashlen,
+                                           argon2_type type,
+                                           const uint32_t version);
+
+/**
+ * Hashes one password with many salts, producing @count raw hashes. Meant for
+ * proof-of-work search, where the password is the block challenge and the
+ * salts are candidate nonces.
+ * The parameters and password are pre-hashed once for the whole batch, and
+ * the items are spread over @threads worker threads, each hashing whole items
+ * (all lanes of an item are filled by the same thread).
+ * @param t_cost Number of iterations
+ * @param m_cost Sets memory usage to m_cost kibibytes
+ * @param parallelism Number of compute lanes of each hash
+ * @param pwd Pointer to password
+ * @param pwdlen Password size in bytes
+ * @param salts @count salts of @saltlen bytes each, back to back
+ * @param saltlen Size of each salt in bytes
+ * @param count Number of salts
+ * @param hashes Buffer of @count * @hashlen bytes receiving the hashes, in
+ * salt order
+ * @param hashlen Desired length of each hash in bytes
+ * @param threads Number of items hashed concurrently
+ * @pre   Each hash equals the one argon2_hash gives for the same salt
+ * @pre   Returns ARGON2_OK if successful
+ */
+ARGON2_PUBLIC int argon2id_hash_raw_batch(const uint32_t t_cost,
+                                          const uint32_t m_cost,
+                                          const uint32_t parallelism,
+                                          const void *pwd, const size_t pwdlen,
+                                          const void *salts,
+                                          const size_t saltlen,
+                                          const size_t count, void *hashes,
+                                          const size_t hashlen,
+                                          const uint32_t threads);
+
+/* generic function underlying the above one */
+ARGON2_PUBLIC int argon2_hash_raw_batch(const uint32_t t_cost,
+                                        const uint32_t m_cost,
+                                        const uint32_t parallelism,
+                                        const void *pwd, const size_t pwdlen,
+                                        const void *salts, const size_t saltlen,
+                                        const size_t count, void *hashes,
+                                        const size_t hashlen,
+                                        const uint32_t threads,
+                                        argon2_type type,
+                                        const uint32_t version);
+
+/**
+ * Searches for a proof-of-work nonce: hashes @pwd with successive nonces until
+ * a hash is found that is not above @hash_ceil, @cancel becomes non-zero or
+ * the time budget runs out.
+ * Nonces are counted big-endian from the one passed in, leaving the first
+ * byte untouched. Each thread fills a group of w nonces at a time, w being
+ * the argon2_set_interleave setting: thread i tries nonces i * w to
+ * i * w + w - 1 past the first, then the same group threads * w further on,
+ * and so on. With w = 1 thread i tries every threads-th nonce starting at i.
+ * @param t_cost Number of iterations
+ * @param m_cost Sets memory usage to m_cost kibibytes
+ * @param parallelism Number of compute lanes of each hash
+ * @param pwd Pointer to the challenge hashed as password
+ * @param pwdlen Challenge size in bytes
+ * @param nonce First nonce to try, used as salt. Holds the solution on
+ * success, or the nonce to continue from otherwise.
+ * @param noncelen Nonce size in bytes, at most ARGON2_POW_MAX_NONCE_LENGTH
+ * @param hash_ceil Target, compared byte by byte and padded with 0xFF to
+ * @hashlen
+ * @param ceillen Target size in bytes
+ * @param hash Receives the hash of the solution
+ * @param hashlen Hash size in bytes, at most ARGON2_POW_MAX_HASH_LENGTH
+ * @param cancel Checked after every hash; the search stops once it is non-zero.
+ * May be NULL.
+ * @param time_budget_ms Stop after about this many milliseconds, 0 for no limit
+ * @param hash_counter Atomically incremented for every hash computed, so that
+ * callers can report a hash rate. May be NULL.
+ * @param threads Number of nonces hashed concurrently
+ * @return ARGON2_OK if a solution was found, ARGON2_POW_NOT_FOUND if the
+ * search was cancelled or ran out of time, another error code otherwise
+ */
+ARGON2_PUBLIC int argon2id_pow_search(const uint32_t t_cost,
+                                      const uint32_t m_cost,
+                                      const uint32_t parallelism,
+                                      const void *pwd, const size_t pwdlen,
+                                      void *nonce, const size_t noncelen,
+                                      const void *hash_ceil,
+                                      const size_t ceillen, void *hash,
+                                      const size_t hashlen,
+                                      const volatile int32_t *cancel,
+                                      const uint32_t time_budget_ms,
+                                      volatile int64_t *hash_counter,
+                                      const uint32_t threads);
+
+/* generic function underlying the above one */
+ARGON2_PUBLIC int argon2_pow_search(const uint32_t t_cost,
+                                    const uint32_t m_cost,
+                                    const uint32_t parallelism,
+                                    const void *pwd, const size_t pwdlen,
+                                    void *nonce, const size_t noncelen,
+                                    const void *hash_ceil, const size_t ceillen,
+                                    void *hash, const size_t hashlen,
+                                    const volatile int32_t *cancel,
+                                    const uint32_t time_budget_ms,
+                                    volatile int64_t *hash_counter,
+                                    const uint32_t threads, argon2_type type);
+
+/**
+ * Checks many proof-of-work solutions at once, spread over @threads threads
+ * @param challenges Challenges of all items, concatenated, used as passwords
+ * @param challenge_lens Length of each item's challenge
+ * @param nonces Nonces of all items, concatenated, used as salts
+ * @param nonce_lens Length of each item's nonce
+ * @param hash_ceils @count ceilings of @ceillen bytes, one per item, compared
+ * like in argon2_pow_search
+ * @param results Bitmap of (@count + 7) / 8 bytes; bit i % 8 of byte i / 8 is
+ * set if item i's hash is not above its ceiling
+ * @param flags ARGON2_POW_VERIFY_* flags
+ * @return ARGON2_OK if every item passed, ARGON2_VERIFY_MISMATCH if any failed
+ * (in short-circuit mode the items not reached are left clear), or an error
+ * code for bad parameters
+ */
+ARGON2_PUBLIC int argon2id_pow_verify_batch(const uint32_t t_cost,
+                                            const uint32_t m_cost,
+                                            const uint32_t parallelism,
+                                            const void *challenges,
+                                            const size_t *challenge_lens,
+                                            const void *nonces,
+                                            const size_t *nonce_lens,
+                                            const void *hash_ceils,
+                                            const size_t ceillen,
+                                            const size_t count,
+                                            const size_t hashlen,
+                                            uint8_t *results,
+                                            const uint32_t threads,
+                                            const uint32_t flags);
+
+/* generic function underlying the above one */
+ARGON2_PUBLIC int argon2_pow_verify_batch(const uint32_t t_cost,
+                                          const uint32_t m_cost,
+                                          const uint32_t parallelism,
+                                          const void *challenges,
+                                          const size_t *challenge_lens,
+                                          const void *nonces,
+                                          const size_t *nonce_lens,
+                                          const void *hash_ceils,
+                                          const size_t ceillen,
+                                          const size_t count,
+                                          const size_t hashlen,
+                                          uint8_t *results,
+                                          const uint32_t threads,
+                                          const uint32_t flags,
+                                          argon2_type type);
+
 /**
  * Verifies a password against an encoded string
  * Encoded string is restricted as in validate_inputs()
@@ -430,6 +665,114 @@ ARGON2_PUBLIC size_t argon2_encodedlen(uint32_t t_cost, uint32_t m_cost,
                                        uint32_t parallelism, uint32_t saltlen,
                                        uint32_t hashlen, argon2_type type);
 
+/*
+ * Reusable instance: the block arena, memory layout and lane worker threads
+ * of one parameter set, kept alive across hashes so that hashing many inputs
+ * with the same costs (mining, nonce verification) allocates nothing.
+ * A reusable instance must only be used by one thread at a time.
+ */
+typedef struct Argon2_reusable_instance_t argon2_reusable_instance;
+
+/**
+ * Creates a reusable instance
+ * @param handle Receives the new instance
+ * @param params Context holding the cost parameters (t_cost, m_cost, lanes,
+ * threads, version) and optionally the allocator callbacks; the input and
+ * output fields are ignored
+ * @param type Argon2 type the instance will hash with
+ * @param flags ARGON2_INSTANCE_FLAG_* options
+ * @return ARGON2_OK if successful, an error code otherwise
+ */
+ARGON2_PUBLIC int argon2_instance_create(argon2_reusable_instance **handle,
+                                         const argon2_context *params,
+                                         argon2_type type, uint32_t flags);
+
+/**
+ * Hashes with a reusable instance, like argon2_ctx but without allocating
+ * @param handle Instance from argon2_instance_create
+ * @param context Inputs and output; t_cost, m_cost, lanes and version must
+ * match the ones the instance was created with. The allocator callbacks and
+ * thread count of @context are ignored.
+ * @return ARGON2_OK if successful, ARGON2_INCORRECT_PARAMETER if the costs
+ * do not match the instance, another error code otherwise
+ */
+ARGON2_PUBLIC int argon2_hash_with_instance(argon2_reusable_instance *handle,
+                                            argon2_context *context);
+
+/**
+ * Hashes a password with a reusable instance, producing a raw hash at @hash
+ * @param handle Instance from argon2_instance_create
+ * @param pwd Pointer to password
+ * @param pwdlen Password size in bytes
+ * @param salt Pointer to salt
+ * @param saltlen Salt size in bytes
+ * @param hash Buffer where to write the raw hash - updated by the function
+ * @param hashlen Desired length of the hash in bytes
+ * @return ARGON2_OK if successful
+ */
+ARGON2_PUBLIC int argon2_hash_raw_with_instance(argon2_reusable_instance *handle,
+                                                const void *pwd,
+                                                const size_t pwdlen,
+                                                const void *salt,
+                                                const size_t saltlen,
+                                                void *hash,
+                                                const size_t hashlen);
+
+/**
+ * Wipes (regardless of ARGON2_INSTANCE_FLAG_NO_WIPE) and frees the arena of a
+ * reusable instance and hands its worker threads back to the pool
+ * @param handle Instance from argon2_instance_create, may be NULL
+ */
+ARGON2_PUBLIC void argon2_instance_destroy(argon2_reusable_instance *handle);
+
+/**
+ * Stops the worker threads that multi-lane hashing keeps parked between calls
+ * and frees their resources. The pool is rebuilt on demand, so this is only
+ * needed before unloading the library. Must not be called while any hashing
+ * function is running.
+ */
+ARGON2_PUBLIC void argon2_pool_shutdown(void);
+
+/**
+ * Returns the fill_block kernel new hashes will use: the one forced with
+ * argon2_set_kernel, or else the fastest one the running CPU supports.
+ * Never returns ARGON2_KERNEL_AUTO.
+ */
+ARGON2_PUBLIC argon2_kernel argon2_get_kernel(void);
+
+/**
+ * Forces the fill_block kernel for hashes started after this call, mainly for
+ * benchmarking and testing. Reusable instances keep the kernel they were
+ * created with.
+ * @param kernel Kernel to use, or ARGON2_KERNEL_AUTO to go back to detection
+ * @return ARGON2_OK, or ARGON2_KERNEL_UNSUPPORTED if the kernel is not built
+ * in or the CPU cannot run it (the selection is then left unchanged)
+ */
+ARGON2_PUBLIC int argon2_set_kernel(argon2_kernel kernel);
+
+/**
+ * Function that gives the string representation of an argon2_kernel.
+ * @param kernel The argon2_kernel that we want the string for
+ * @return NULL if invalid kernel, otherwise the string representation.
+ */
+ARGON2_PUBLIC const char *argon2_kernel2string(argon2_kernel kernel);
+
+/**
+ * Returns how many independent hashes argon2_hash_raw_batch and
+ * argon2_pow_search fill in lockstep on each thread.
+ */
+ARGON2_PUBLIC uint32_t argon2_get_interleave(void);
+
+/**
+ * Sets how many independent hashes argon2_hash_raw_batch and
+ * argon2_pow_search fill in lockstep on each thread. Interleaving hides the
+ * latency of Argon2d's data-dependent block loads behind the other hashes'
+ * compression; it pays off while all of their memory fits in the L2 cache.
+ * @param ways 1 (no interleaving) to ARGON2_MAX_INTERLEAVE
+ * @return ARGON2_OK, or ARGON2_INCORRECT_PARAMETER if @ways is out of range
+ */
+ARGON2_PUBLIC int argon2_set_interleave(uint32_t ways);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -22,6 +22,7 @@
 #include "argon2.h"
 #include "encoding.h"
 #include "core.h"
+#include "pool.h"
 
 const char *argon2_type2string(argon2_type type, int uppercase) {
     switch (type) {
@@ -39,7 +40,6 @@ const char *argon2_type2string(argon2_type type, int uppercase) {
 int argon2_ctx(argon2_context *context, argon2_type type) {
     /* 1. Validate all inputs */
     int result = validate_inputs(context);
-    uint32_t memory_blocks, segment_length;
     argon2_instance_t instance;
 
     if (ARGON2_OK != result) {
@@ -51,30 +51,7 @@ int argon2_ctx(argon2_context *context, argon2_type type) {
     }
 
     /* 2. Align memory size */
-    /* Minimum memory_blocks = 8L blocks, where L is the number of lanes */
-    memory_blocks = context->m_cost;
-
-    if (memory_blocks < 2 * ARGON2_SYNC_POINTS * context->lanes) {
-        memory_blocks = 2 * ARGON2_SYNC_POINTS * context->lanes;
-    }
-
-    segment_length = memory_blocks / (context->lanes * ARGON2_SYNC_POINTS);
-    /* Ensure that all segments have equal length */
-    memory_blocks = segment_length * (context->lanes * ARGON2_SYNC_POINTS);
-
-    instance.version = context->version;
-    instance.memory = NULL;
-    instance.passes = context->t_cost;
-    instance.memory_blocks = memory_blocks;
-    instance.segment_length = segment_length;
-    instance.lane_length = segment_length * ARGON2_SYNC_POINTS;
-    instance.lanes = context->lanes;
-    instance.threads = context->threads;
-    instance.type = type;
-
-    if (instance.threads > instance.lanes) {
-        instance.threads = instance.lanes;
-    }
+    init_instance(&instance, context, type);
 
     /* 3. Initialization: Hashing inputs, allocating memory, filling first
      * blocks
@@ -97,6 +74,193 @@ int argon2_ctx(argon2_context *context, argon2_type type) {
     return ARGON2_OK;
 }
 
+struct Argon2_reusable_instance_t {
+    argon2_instance_t instance; /* layout, arena and workers */
+    argon2_context params;      /* cost parameters and allocator */
+    uint32_t flags;             /* ARGON2_INSTANCE_FLAG_* */
+    size_t memory_size;         /* bytes mapped for a huge-page arena */
+};
+
+int argon2_instance_create(argon2_reusable_instance **handle,
+                           const argon2_context *params, argon2_type type,
+                           uint32_t flags) {
+    argon2_reusable_instance *h;
+    argon2_context check;
+    uint8_t dummy_out[ARGON2_MIN_OUTLEN];
+    int result;
+
+    if (handle == NULL || params == NULL) {
+        return ARGON2_INCORRECT_PARAMETER;
+    }
+    *handle = NULL;
+
+    if (Argon2_d != type && Argon2_i != type && Argon2_id != type) {
+        return ARGON2_INCORRECT_TYPE;
+    }
+
+    /* Only the cost parameters and the allocator matter here */
+    memset(&check, 0, sizeof(check));
+    check.out = dummy_out;
+    check.outlen = ARGON2_MIN_OUTLEN;
+    check.saltlen = ARGON2_MIN_SALT_LENGTH;
+    check.salt = dummy_out;
+    check.t_cost = params->t_cost;
+    check.m_cost = params->m_cost;
+    check.lanes = params->lanes;
+    check.threads = params->threads;
+    check.version = params->version;
+    check.allocate_cbk = params->allocate_cbk;
+    check.free_cbk = params->free_cbk;
+    result = validate_inputs(&check);
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+    h = calloc(1, sizeof(argon2_reusable_instance));
+    if (h == NULL) {
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+    h->params = check;
+    h->params.out = NULL;
+    h->params.outlen = 0;
+    h->params.salt = NULL;
+    h->params.saltlen = 0;
+    h->flags = flags;
+
+    init_instance(&h->instance, &h->params, type);
+    h->instance.keep_memory = 1;
+
+    if ((flags & ARGON2_INSTANCE_FLAG_HUGE_PAGES) &&
+        h->params.allocate_cbk == NULL) {
+        h->memory_size = (size_t)h->instance.memory_blocks * sizeof(block);
+        result = allocate_pages((uint8_t **)&h->instance.memory,
+                                &h->memory_size);
+    } else {
+        result = allocate_memory(&h->params, (uint8_t **)&h->instance.memory,
+                                 h->instance.memory_blocks, sizeof(block));
+    }
+    if (ARGON2_OK != result) {
+        free(h);
+        return result;
+    }
+
+#if !defined(ARGON2_NO_THREADS)
+    /* Keep the lane workers for the whole lifetime of the instance */
+    if (h->instance.threads > 1) {
+        argon2_team_t *team = NULL;
+        result = argon2_team_acquire(&team, h->instance.threads);
+        if (ARGON2_OK != result) {
+            h->instance.team = NULL;
+            argon2_instance_destroy(h);
+            return result;
+        }
+        h->instance.team = team;
+    }
+#endif
+
+    *handle = h;
+    return ARGON2_OK;
+}
+
+int argon2_hash_with_instance(argon2_reusable_instance *handle,
+                              argon2_context *context) {
+    argon2_instance_t instance;
+    int result;
+
+    if (handle == NULL) {
+        return ARGON2_INCORRECT_PARAMETER;
+    }
+
+    result = validate_inputs(context);
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+    /* The arena was laid out for these parameters */
+    if (context->t_cost != handle->params.t_cost ||
+        context->m_cost != handle->params.m_cost ||
+        context->lanes != handle->params.lanes ||
+        context->version != handle->params.version) {
+        return ARGON2_INCORRECT_PARAMETER;
+    }
+
+    instance = handle->instance;
+
+    result = initialize(&instance, context);
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+    result = fill_memory_blocks(&instance);
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+    finalize(context, &instance);
+
+    if (!(handle->flags & ARGON2_INSTANCE_FLAG_NO_WIPE)) {
+        clear_internal_memory(instance.memory,
+                              (size_t)instance.memory_blocks * sizeof(block));
+    }
+
+    return ARGON2_OK;
+}
+
+int argon2_hash_raw_with_instance(argon2_reusable_instance *handle,
+                                  const void *pwd, const size_t pwdlen,
+                                  const void *salt, const size_t saltlen,
+                                  void *hash, const size_t hashlen) {
+    argon2_context context;
+
+    if (handle == NULL) {
+        return ARGON2_INCORRECT_PARAMETER;
+    }
+
+    if (pwdlen > ARGON2_MAX_PWD_LENGTH) {
+        return ARGON2_PWD_TOO_LONG;
+    }
+
+    if (saltlen > ARGON2_MAX_SALT_LENGTH) {
+        return ARGON2_SALT_TOO_LONG;
+    }
+
+    if (hashlen > ARGON2_MAX_OUTLEN) {
+        return ARGON2_OUTPUT_TOO_LONG;
+    }
+
+    context = handle->params;
+    context.out = (uint8_t *)hash;
+    context.outlen = (uint32_t)hashlen;
+    context.pwd = CONST_CAST(uint8_t *)pwd;
+    context.pwdlen = (uint32_t)pwdlen;
+    context.salt = CONST_CAST(uint8_t *)salt;
+    context.saltlen = (uint32_t)saltlen;
+    context.flags = ARGON2_DEFAULT_FLAGS;
+
+    return argon2_hash_with_instance(handle, &context);
+}
+
+void argon2_instance_destroy(argon2_reusable_instance *handle) {
+    if (handle == NULL) {
+        return;
+    }
+
+#if !defined(ARGON2_NO_THREADS)
+    if (handle->instance.team != NULL) {
+        argon2_team_release(handle->instance.team);
+    }
+#endif
+
+    if (handle->memory_size != 0) {
+        clear_internal_memory(handle->instance.memory, handle->memory_size);
+        free_pages((uint8_t *)handle->instance.memory, handle->memory_size);
+    } else if (handle->instance.memory != NULL) {
+        free_memory(&handle->params, (uint8_t *)handle->instance.memory,
+                    handle->instance.memory_blocks, sizeof(block));
+    }
+    free(handle);
+}
+
 int argon2_hash(const uint32_t t_cost, const uint32_t m_cost,
                 const uint32_t parallelism, const void *pwd,
                 const size_t pwdlen, const void *salt, const size_t saltlen,
@@ -236,6 +400,282 @@ int argon2id_hash_raw(const uint32_t t_cost, const uint32_t m_cost,
                        ARGON2_VERSION_NUMBER);
 }
 
+int argon2_hash_raw_segments(const uint32_t t_cost, const uint32_t m_cost,
+                             const uint32_t parallelism,
+                             const argon2_segment *segments,
+                             const size_t count, const void *salt,
+                             const size_t saltlen, void *hash,
+                             const size_t hashlen, argon2_type type,
+                             const uint32_t version) {
+    argon2_context context;
+    argon2_instance_t instance;
+    blake2b_state prefix;
+    size_t pwdlen = 0;
+    size_t i;
+    int result;
+
+    if (count != 0 && segments == NULL) {
+        return ARGON2_PWD_PTR_MISMATCH;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (segments[i].data == NULL && segments[i].len != 0) {
+            return ARGON2_PWD_PTR_MISMATCH;
+        }
+        if (segments[i].len > ARGON2_MAX_PWD_LENGTH - pwdlen) {
+            return ARGON2_PWD_TOO_LONG;
+        }
+        pwdlen += segments[i].len;
+    }
+
+    if (saltlen > ARGON2_MAX_SALT_LENGTH) {
+        return ARGON2_SALT_TOO_LONG;
+    }
+
+    if (hashlen > ARGON2_MAX_OUTLEN) {
+        return ARGON2_OUTPUT_TOO_LONG;
+    }
+
+    context.out = (uint8_t *)hash;
+    context.outlen = (uint32_t)hashlen;
+    context.pwd = NULL;
+    context.pwdlen = 0;
+    context.salt = CONST_CAST(uint8_t *)salt;
+    context.saltlen = (uint32_t)saltlen;
+    context.secret = NULL;
+    context.secretlen = 0;
+    context.ad = NULL;
+    context.adlen = 0;
+    context.t_cost = t_cost;
+    context.m_cost = m_cost;
+    context.lanes = parallelism;
+    context.threads = parallelism;
+    context.allocate_cbk = NULL;
+    context.free_cbk = NULL;
+    context.flags = ARGON2_DEFAULT_FLAGS;
+    context.version = version;
+
+    /* The segments were checked above; the rest as for argon2_ctx */
+    result = validate_inputs(&context);
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+    if (Argon2_d != type && Argon2_i != type && Argon2_id != type) {
+        return ARGON2_INCORRECT_TYPE;
+    }
+
+    init_instance(&instance, &context, type);
+
+    /* Absorb the segments where initial_hash would absorb the password */
+    context.pwdlen = (uint32_t)pwdlen;
+    initial_hash_prefix(&prefix, &context, type);
+    for (i = 0; i < count; i++) {
+        if (segments[i].len != 0) {
+            blake2b_update(&prefix, segments[i].data, segments[i].len);
+        }
+    }
+
+    result = initialize_with_prefix(&instance, &context, &prefix);
+    clear_internal_memory(&prefix, sizeof(prefix));
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+    result = fill_memory_blocks(&instance);
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+    finalize(&context, &instance);
+
+    return ARGON2_OK;
+}
+
+int argon2id_hash_raw_segments(const uint32_t t_cost, const uint32_t m_cost,
+                               const uint32_t parallelism,
+                               const argon2_segment *segments,
+                               const size_t count, const void *salt,
+                               const size_t saltlen, void *hash,
+                               const size_t hashlen) {
+    return argon2_hash_raw_segments(t_cost, m_cost, parallelism, segments,
+                                    count, salt, saltlen, hash, hashlen,
+                                    Argon2_id, ARGON2_VERSION_NUMBER);
+}
+
+/* Shared state of one argon2_hash_raw_batch call */
+typedef struct Argon2_batch_job {
+    argon2_instance_t instance; /* layout shared by all items */
+    argon2_context context;     /* parameters and password */
+    blake2b_state prefix;       /* initial hash state up to the password */
+    block **arenas;             /* per member, ways instances each */
+    const uint8_t *salts;
+    uint8_t *hashes;
+    size_t count;
+    uint32_t members;
+    uint32_t ways;              /* items filled together by one member */
+} argon2_batch_job;
+
+/* Member m hashes groups of ways items m, m + members, ... with the items of
+ * a group filled in lockstep */
+static void hash_batch_thr(void *job_data, uint32_t member) {
+    argon2_batch_job *job = job_data;
+    argon2_instance_t instances[ARGON2_MAX_INTERLEAVE];
+    argon2_instance_t *group[ARGON2_MAX_INTERLEAVE];
+    argon2_context contexts[ARGON2_MAX_INTERLEAVE];
+    size_t first, i;
+    uint32_t j, n;
+
+    for (j = 0; j < job->ways; j++) {
+        instances[j] = job->instance;
+        instances[j].memory =
+            job->arenas[member] + (size_t)j * job->instance.memory_blocks;
+        group[j] = &instances[j];
+    }
+
+    for (first = (size_t)member * job->ways; first < job->count;
+         first += (size_t)job->members * job->ways) {
+        n = 0;
+        for (i = first; i < job->count && n < job->ways; i++, n++) {
+            contexts[n] = job->context;
+            contexts[n].salt =
+                CONST_CAST(uint8_t *)(job->salts + i * job->context.saltlen);
+            contexts[n].out = job->hashes + i * job->context.outlen;
+            initialize_with_prefix(&instances[n], &contexts[n], &job->prefix);
+        }
+
+        fill_memory_blocks_interleaved(group, n);
+
+        for (j = 0; j < n; j++) {
+            finalize(&contexts[j], &instances[j]);
+        }
+    }
+}
+
+int argon2_hash_raw_batch(const uint32_t t_cost, const uint32_t m_cost,
+                          const uint32_t parallelism, const void *pwd,
+                          const size_t pwdlen, const void *salts,
+                          const size_t saltlen, const size_t count,
+                          void *hashes, const size_t hashlen,
+                          const uint32_t threads, argon2_type type,
+                          const uint32_t version) {
+    argon2_batch_job job;
+    int result;
+
+    if (pwdlen > ARGON2_MAX_PWD_LENGTH) {
+        return ARGON2_PWD_TOO_LONG;
+    }
+
+    if (saltlen > ARGON2_MAX_SALT_LENGTH) {
+        return ARGON2_SALT_TOO_LONG;
+    }
+
+    if (hashlen > ARGON2_MAX_OUTLEN) {
+        return ARGON2_OUTPUT_TOO_LONG;
+    }
+
+    if (Argon2_d != type && Argon2_i != type && Argon2_id != type) {
+        return ARGON2_INCORRECT_TYPE;
+    }
+
+    if (count == 0) {
+        return ARGON2_OK;
+    }
+
+    if (salts == NULL || hashes == NULL || threads == 0) {
+        return ARGON2_INCORRECT_PARAMETER;
+    }
+
+    job.context.out = (uint8_t *)hashes;
+    job.context.outlen = (uint32_t)hashlen;
+    job.context.pwd = CONST_CAST(uint8_t *)pwd;
+    job.context.pwdlen = (uint32_t)pwdlen;
+    job.context.salt = CONST_CAST(uint8_t *)salts;
+    job.context.saltlen = (uint32_t)saltlen;
+    job.context.secret = NULL;
+    job.context.secretlen = 0;
+    job.context.ad = NULL;
+    job.context.adlen = 0;
+    job.context.t_cost = t_cost;
+    job.context.m_cost = m_cost;
+    job.context.lanes = parallelism;
+    job.context.threads = parallelism;
+    job.context.allocate_cbk = NULL;
+    job.context.free_cbk = NULL;
+    job.context.flags = ARGON2_DEFAULT_FLAGS;
+    job.context.version = version;
+
+    result = validate_inputs(&job.context);
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+    /* Items are spread over the members, so each hash fills its lanes on a
+     * single thread without any slice barriers */
+    init_instance(&job.instance, &job.context, type);
+    job.instance.threads = 1;
+    job.instance.keep_memory = 1;
+
+    job.salts = (const uint8_t *)salts;
+    job.hashes = (uint8_t *)hashes;
+    job.count = count;
+    job.members = threads;
+    if (job.members > count) {
+        job.members = (uint32_t)count;
+    }
+#if defined(ARGON2_NO_THREADS)
+    job.members = 1;
+#endif
+    /* Spread the items over the threads first, then interleave what is left
+     * on each */
+    job.ways = argon2_get_interleave();
+    if (job.ways > (count + job.members - 1) / job.members) {
+        job.ways = (uint32_t)((count + job.members - 1) / job.members);
+    }
+
+    /* The parameters and password are the same for every item */
+    initial_hash_prefix(&job.prefix, &job.context, type);
+
+    result = allocate_member_arenas(&job.arenas, job.members,
+                                    (size_t)job.ways *
+                                        job.instance.memory_blocks);
+    if (ARGON2_OK != result) {
+        clear_internal_memory(&job.prefix, sizeof(job.prefix));
+        return result;
+    }
+
+#if !defined(ARGON2_NO_THREADS)
+    if (job.members > 1) {
+        argon2_team_t *team = NULL;
+        result = argon2_team_acquire(&team, job.members);
+        if (ARGON2_OK == result) {
+            argon2_team_run(team, &hash_batch_thr, &job);
+            argon2_team_release(team);
+        }
+    } else
+#endif
+    {
+        hash_batch_thr(&job, 0);
+    }
+
+    free_member_arenas(job.arenas, job.members,
+                       (size_t)job.ways * job.instance.memory_blocks, 1);
+    clear_internal_memory(&job.prefix, sizeof(job.prefix));
+
+    return result;
+}
+
+int argon2id_hash_raw_batch(const uint32_t t_cost, const uint32_t m_cost,
+                            const uint32_t parallelism, const void *pwd,
+                            const size_t pwdlen, const void *salts,
+                            const size_t saltlen, const size_t count,
+                            void *hashes, const size_t hashlen,
+                            const uint32_t threads) {
+    return argon2_hash_raw_batch(t_cost, m_cost, parallelism, pwd, pwdlen,
+                                 salts, saltlen, count, hashes, hashlen,
+                                 threads, Argon2_id, ARGON2_VERSION_NUMBER);
+}
+
 static int argon2_compare(const uint8_t *b1, const uint8_t *b2, size_t len) {
     size_t i;
     uint8_t d = 0U;
@@ -439,6 +879,10 @@ const char *argon2_error_message(int error_code) {
         return "Some of encoded parameters are too long or too short";
     case ARGON2_VERIFY_MISMATCH:
         return "The password does not match the supplied hash";
+    case ARGON2_POW_NOT_FOUND:
+        return "No proof-of-work solution was found";
+    case ARGON2_KERNEL_UNSUPPORTED:
+        return "The requested kernel is not supported on this CPU";
     default:
         return "Unknown error code";
     }
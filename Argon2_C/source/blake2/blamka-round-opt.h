@@ -20,6 +20,21 @@
 
 #include "blake2-impl.h"
 
+/* The fill_block kernels pick their instruction set by defining one of
+ * ARGON2_OPT_SSE2, ARGON2_OPT_AVX2 or ARGON2_OPT_AVX512F before including this
+ * header, so that one library can carry all of them. Without one, the
+ * compiler's target flags decide as before. */
+#if !defined(ARGON2_OPT_SSE2) && !defined(ARGON2_OPT_AVX2) &&                 \
+    !defined(ARGON2_OPT_AVX512F)
+#if defined(__AVX512F__)
+#define ARGON2_OPT_AVX512F
+#elif defined(__AVX2__)
+#define ARGON2_OPT_AVX2
+#else
+#define ARGON2_OPT_SSE2
+#endif
+#endif
+
 #include <emmintrin.h>
 #if defined(__SSSE3__)
 #include <tmmintrin.h> /* for _mm_shuffle_epi8 and _mm_alignr_epi8 */
@@ -29,8 +44,8 @@
 #include <x86intrin.h>
 #endif
 
-#if !defined(__AVX512F__)
-#if !defined(__AVX2__)
+#if !defined(ARGON2_OPT_AVX512F)
+#if !defined(ARGON2_OPT_AVX2)
 #if !defined(__XOP__)
 #if defined(__SSSE3__)
 #define r16                                                                    \
@@ -178,7 +193,7 @@ static BLAKE2_INLINE __m128i fBlaMka(__m128i x, __m128i y) {
                                                                                \
         UNDIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1);                         \
     } while ((void)0, 0)
-#else /* __AVX2__ */
+#else /* ARGON2_OPT_AVX2 */
 
 #include <immintrin.h>
 
@@ -325,9 +340,9 @@ static BLAKE2_INLINE __m128i fBlaMka(__m128i x, __m128i y) {
         UNDIAGONALIZE_2(A0, A1, B0, B1, C0, C1, D0, D1) \
     } while((void)0, 0);
 
-#endif /* __AVX2__ */
+#endif /* ARGON2_OPT_AVX2 */
 
-#else /* __AVX512F__ */
+#else /* ARGON2_OPT_AVX512F */
 
 #include <immintrin.h>
 
@@ -467,5 +482,5 @@ static __m512i muladd(__m512i x, __m512i y)
         UNSWAP_QUARTERS(D0, D1); \
     } while ((void)0, 0)
 
-#endif /* __AVX512F__ */
+#endif /* ARGON2_OPT_AVX512F */
 #endif /* BLAKE_ROUND_MKA_OPT_H */
@@ -20,6 +20,11 @@
 #include <windows.h>
 #include <winbase.h> /* For SecureZeroMemory */
 #endif
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
 #if defined __STDC_LIB_EXT1__
 #define __STDC_WANT_LIB_EXT1__ 1
 #endif
@@ -31,6 +36,7 @@
 
 #include "core.h"
 #include "thread.h"
+#include "pool.h"
 #include "blake2/blake2.h"
 #include "blake2/blake2-impl.h"
 
@@ -98,6 +104,8 @@ int allocate_memory(const argon2_context *context, uint8_t **memory,
     /* 2. Try to allocate with appropriate allocator */
     if (context->allocate_cbk) {
         (context->allocate_cbk)(memory, memory_size);
+    } else if (context->flags & ARGON2_FLAG_HUGE_PAGES) {
+        return allocate_pages(memory, &memory_size);
     } else {
         *memory = malloc(memory_size);
     }
@@ -115,11 +123,139 @@ void free_memory(const argon2_context *context, uint8_t *memory,
     clear_internal_memory(memory, memory_size);
     if (context->free_cbk) {
         (context->free_cbk)(memory, memory_size);
+    } else if (context->flags & ARGON2_FLAG_HUGE_PAGES) {
+        free_pages(memory, memory_size);
     } else {
         free(memory);
     }
 }
 
+/* Transparent huge pages on x86-64 */
+#define ARGON2_HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+int allocate_pages(uint8_t **memory, size_t *size) {
+    if (memory == NULL || size == NULL || *size == 0) {
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+#if defined(_WIN32)
+    {
+        /* Large pages need SeLockMemoryPrivilege; fall back if refused */
+        size_t large = GetLargePageMinimum();
+        if (large != 0) {
+            size_t len = (*size + large - 1) / large * large;
+            *memory = VirtualAlloc(NULL, len,
+                                   MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                   PAGE_READWRITE);
+            if (*memory != NULL) {
+                *size = len;
+                return ARGON2_OK;
+            }
+        }
+        *memory = VirtualAlloc(NULL, *size, MEM_RESERVE | MEM_COMMIT,
+                               PAGE_READWRITE);
+    }
+#else
+    {
+        /* Round up to whole huge pages and align the start, so the kernel
+         * can back the arena with transparent huge pages */
+        size_t len = (*size + ARGON2_HUGE_PAGE_SIZE - 1) /
+                     ARGON2_HUGE_PAGE_SIZE * ARGON2_HUGE_PAGE_SIZE;
+        size_t head, tail;
+        uint8_t *raw;
+#if defined(MAP_HUGETLB)
+        /* Reserved huge pages (vm.nr_hugepages) come first; they are
+         * aligned by construction. Without a reservation this fails. */
+        raw = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (raw != MAP_FAILED) {
+            *memory = raw;
+            *size = len;
+            return ARGON2_OK;
+        }
+#endif
+        raw = mmap(NULL, len + ARGON2_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            *memory = NULL;
+            return ARGON2_MEMORY_ALLOCATION_ERROR;
+        }
+        head = (ARGON2_HUGE_PAGE_SIZE -
+                (uintptr_t)raw % ARGON2_HUGE_PAGE_SIZE) % ARGON2_HUGE_PAGE_SIZE;
+        tail = ARGON2_HUGE_PAGE_SIZE - head;
+        if (head != 0) {
+            munmap(raw, head);
+        }
+        if (tail != 0) {
+            munmap(raw + head + len, tail);
+        }
+        *memory = raw + head;
+#if defined(MADV_HUGEPAGE)
+        madvise(*memory, len, MADV_HUGEPAGE);
+#endif
+        *size = len;
+    }
+#endif
+    if (*memory == NULL) {
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+    return ARGON2_OK;
+}
+
+void free_pages(uint8_t *memory, size_t size) {
+    if (memory == NULL) {
+        return;
+    }
+#if defined(_WIN32)
+    (void)size;
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, (size + ARGON2_HUGE_PAGE_SIZE - 1) / ARGON2_HUGE_PAGE_SIZE *
+                       ARGON2_HUGE_PAGE_SIZE);
+#endif
+}
+
+int allocate_member_arenas(block ***arenas, uint32_t members, size_t blocks) {
+    uint32_t i;
+
+    if (arenas == NULL || members == 0 ||
+        blocks > SIZE_MAX / sizeof(block)) {
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+
+    *arenas = calloc(members, sizeof(block *));
+    if (*arenas == NULL) {
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+
+    for (i = 0; i < members; i++) {
+        size_t size = blocks * sizeof(block);
+        if (ARGON2_OK != allocate_pages((uint8_t **)&(*arenas)[i], &size)) {
+            free_member_arenas(*arenas, members, blocks, 0);
+            *arenas = NULL;
+            return ARGON2_MEMORY_ALLOCATION_ERROR;
+        }
+    }
+    return ARGON2_OK;
+}
+
+void free_member_arenas(block **arenas, uint32_t members, size_t blocks,
+                        int wipe) {
+    uint32_t i;
+
+    if (arenas == NULL) {
+        return;
+    }
+    for (i = 0; i < members; i++) {
+        if (arenas[i] != NULL) {
+            if (wipe) {
+                clear_internal_memory(arenas[i], blocks * sizeof(block));
+            }
+            free_pages((uint8_t *)arenas[i], blocks * sizeof(block));
+        }
+    }
+    free(arenas);
+}
+
 void NOT_OPTIMIZED secure_wipe_memory(void *v, size_t n) {
 #if defined(_MSC_VER) && VC_GE_2005(_MSC_VER)
     SecureZeroMemory(v, n);
@@ -170,8 +306,43 @@ void finalize(const argon2_context *context, argon2_instance_t *instance) {
         print_tag(context->out, context->outlen);
 #endif
 
-        free_memory(context, (uint8_t *)instance->memory,
-                    instance->memory_blocks, sizeof(block));
+        if (!instance->keep_memory) {
+            free_memory(context, (uint8_t *)instance->memory,
+                        instance->memory_blocks, sizeof(block));
+        }
+    }
+}
+
+void init_instance(argon2_instance_t *instance, const argon2_context *context,
+                   argon2_type type) {
+    uint32_t memory_blocks, segment_length;
+
+    /* Minimum memory_blocks = 8L blocks, where L is the number of lanes */
+    memory_blocks = context->m_cost;
+
+    if (memory_blocks < 2 * ARGON2_SYNC_POINTS * context->lanes) {
+        memory_blocks = 2 * ARGON2_SYNC_POINTS * context->lanes;
+    }
+
+    segment_length = memory_blocks / (context->lanes * ARGON2_SYNC_POINTS);
+    /* Ensure that all segments have equal length */
+    memory_blocks = segment_length * (context->lanes * ARGON2_SYNC_POINTS);
+
+    instance->version = context->version;
+    instance->memory = NULL;
+    instance->passes = context->t_cost;
+    instance->memory_blocks = memory_blocks;
+    instance->segment_length = segment_length;
+    instance->lane_length = segment_length * ARGON2_SYNC_POINTS;
+    instance->lanes = context->lanes;
+    instance->threads = context->threads;
+    instance->type = type;
+    instance->keep_memory = 0;
+    instance->team = NULL;
+    instance->kernel = argon2_get_kernel();
+
+    if (instance->threads > instance->lanes) {
+        instance->threads = instance->lanes;
     }
 }
 
@@ -265,81 +436,46 @@ static int fill_memory_blocks_st(argon2_instance_t *instance) {
 
 #if !defined(ARGON2_NO_THREADS)
 
-#ifdef _WIN32
-static unsigned __stdcall fill_segment_thr(void *thread_data)
-#else
-static void *fill_segment_thr(void *thread_data)
-#endif
-{
+static void fill_segment_thr(void *thread_data, uint32_t member) {
     argon2_thread_data *my_data = thread_data;
-    fill_segment(my_data->instance_ptr, my_data->pos);
-    argon2_thread_exit();
-    return 0;
+    argon2_instance_t *instance = my_data->instance_ptr;
+    argon2_position_t position = my_data->pos;
+    uint32_t l;
+
+    /* Member m fills lanes m, m + threads, m + 2 * threads, ... */
+    for (l = member; l < instance->lanes; l += instance->threads) {
+        position.lane = l;
+        position.index = 0;
+        fill_segment(instance, position);
+    }
 }
 
 /* Multi-threaded version for p > 1 case */
 static int fill_memory_blocks_mt(argon2_instance_t *instance) {
     uint32_t r, s;
-    argon2_thread_handle_t *thread = NULL;
-    argon2_thread_data *thr_data = NULL;
-    int rc = ARGON2_OK;
-
-    /* 1. Allocating space for threads */
-    thread = calloc(instance->lanes, sizeof(argon2_thread_handle_t));
-    if (thread == NULL) {
-        rc = ARGON2_MEMORY_ALLOCATION_ERROR;
-        goto fail;
+    argon2_team_t *team = instance->team;
+    argon2_thread_data thr_data;
+
+    /* 1. Taking a team of persistent workers from the pool, unless the
+     * instance already holds one */
+    if (team == NULL) {
+        int rc = argon2_team_acquire(&team, instance->threads);
+        if (rc != ARGON2_OK) {
+            return rc;
+        }
     }
 
-    thr_data = calloc(instance->lanes, sizeof(argon2_thread_data));
-    if (thr_data == NULL) {
-        rc = ARGON2_MEMORY_ALLOCATION_ERROR;
-        goto fail;
-    }
+    thr_data.instance_ptr = instance; /* preparing the thread input */
 
     for (r = 0; r < instance->passes; ++r) {
         for (s = 0; s < ARGON2_SYNC_POINTS; ++s) {
-            uint32_t l;
-
-            /* 2. Calling threads */
-            for (l = 0; l < instance->lanes; ++l) {
-                argon2_position_t position;
-
-                /* 2.1 Join a thread if limit is exceeded */
-                if (l >= instance->threads) {
-                    if (argon2_thread_join(thread[l - instance->threads])) {
-                        rc = ARGON2_THREAD_FAIL;
-                        goto fail;
-                    }
-                }
-
-                /* 2.2 Create thread */
-                position.pass = r;
-                position.lane = l;
-                position.slice = (uint8_t)s;
-                position.index = 0;
-                thr_data[l].instance_ptr =
-                    instance; /* preparing the thread input */
-                memcpy(&(thr_data[l].pos), &position,
-                       sizeof(argon2_position_t));
-                if (argon2_thread_create(&thread[l], &fill_segment_thr,
-                                         (void *)&thr_data[l])) {
-                    rc = ARGON2_THREAD_FAIL;
-                    goto fail;
-                }
-
-                /* fill_segment(instance, position); */
-                /*Non-thread equivalent of the lines above */
-            }
-
-            /* 3. Joining remaining threads */
-            for (l = instance->lanes - instance->threads; l < instance->lanes;
-                 ++l) {
-                if (argon2_thread_join(thread[l])) {
-                    rc = ARGON2_THREAD_FAIL;
-                    goto fail;
-                }
-            }
+            /* 2. Filling the slice on all members; returning from the run is
+             * the synchronization point between slices */
+            thr_data.pos.pass = r;
+            thr_data.pos.lane = 0;
+            thr_data.pos.slice = (uint8_t)s;
+            thr_data.pos.index = 0;
+            argon2_team_run(team, &fill_segment_thr, &thr_data);
         }
 
 #ifdef GENKAT
@@ -347,14 +483,11 @@ static int fill_memory_blocks_mt(argon2_instance_t *instance) {
 #endif
     }
 
-fail:
-    if (thread != NULL) {
-        free(thread);
+    /* 3. Handing the workers back for the next call */
+    if (team != instance->team) {
+        argon2_team_release(team);
     }
-    if (thr_data != NULL) {
-        free(thr_data);
-    }
-    return rc;
+    return ARGON2_OK;
 }
 
 #endif /* ARGON2_NO_THREADS */
@@ -371,6 +504,27 @@ int fill_memory_blocks(argon2_instance_t *instance) {
 #endif
 }
 
+int fill_memory_blocks_interleaved(argon2_instance_t *const *instances,
+                                   uint32_t count) {
+    uint32_t r, s, l;
+
+    if (instances == NULL || count == 0 || count > ARGON2_MAX_INTERLEAVE) {
+        return ARGON2_INCORRECT_PARAMETER;
+    }
+
+    for (r = 0; r < instances[0]->passes; ++r) {
+        for (s = 0; s < ARGON2_SYNC_POINTS; ++s) {
+            for (l = 0; l < instances[0]->lanes; ++l) {
+                argon2_position_t position = {r, l, (uint8_t)s, 0};
+                fill_segment_multi(
+                    (const argon2_instance_t *const *)instances, count,
+                    position);
+            }
+        }
+    }
+    return ARGON2_OK;
+}
+
 int validate_inputs(const argon2_context *context) {
     if (NULL == context) {
         return ARGON2_INCORRECT_PARAMETER;
@@ -521,40 +675,39 @@ void fill_first_blocks(uint8_t *blockhash, const argon2_instance_t *instance) {
     clear_internal_memory(blockhash_bytes, ARGON2_BLOCK_SIZE);
 }
 
-void initial_hash(uint8_t *blockhash, argon2_context *context,
-                  argon2_type type) {
-    blake2b_state BlakeHash;
+void initial_hash_prefix(blake2b_state *BlakeHash, argon2_context *context,
+                         argon2_type type) {
     uint8_t value[sizeof(uint32_t)];
 
-    if (NULL == context || NULL == blockhash) {
+    if (NULL == context || NULL == BlakeHash) {
         return;
     }
 
-    blake2b_init(&BlakeHash, ARGON2_PREHASH_DIGEST_LENGTH);
+    blake2b_init(BlakeHash, ARGON2_PREHASH_DIGEST_LENGTH);
 
     store32(&value, context->lanes);
-    blake2b_update(&BlakeHash, (const uint8_t *)&value, sizeof(value));
+    blake2b_update(BlakeHash, (const uint8_t *)&value, sizeof(value));
 
     store32(&value, context->outlen);
-    blake2b_update(&BlakeHash, (const uint8_t *)&value, sizeof(value));
+    blake2b_update(BlakeHash, (const uint8_t *)&value, sizeof(value));
 
     store32(&value, context->m_cost);
-    blake2b_update(&BlakeHash, (const uint8_t *)&value, sizeof(value));
+    blake2b_update(BlakeHash, (const uint8_t *)&value, sizeof(value));
 
     store32(&value, context->t_cost);
-    blake2b_update(&BlakeHash, (const uint8_t *)&value, sizeof(value));
+    blake2b_update(BlakeHash, (const uint8_t *)&value, sizeof(value));
 
     store32(&value, context->version);
-    blake2b_update(&BlakeHash, (const uint8_t *)&value, sizeof(value));
+    blake2b_update(BlakeHash, (const uint8_t *)&value, sizeof(value));
 
     store32(&value, (uint32_t)type);
-    blake2b_update(&BlakeHash, (const uint8_t *)&value, sizeof(value));
+    blake2b_update(BlakeHash, (const uint8_t *)&value, sizeof(value));
 
     store32(&value, context->pwdlen);
-    blake2b_update(&BlakeHash, (const uint8_t *)&value, sizeof(value));
+    blake2b_update(BlakeHash, (const uint8_t *)&value, sizeof(value));
 
     if (context->pwd != NULL) {
-        blake2b_update(&BlakeHash, (const uint8_t *)context->pwd,
+        blake2b_update(BlakeHash, (const uint8_t *)context->pwd,
                        context->pwdlen);
 
         if (context->flags & ARGON2_FLAG_CLEAR_PASSWORD) {
@@ -562,20 +715,29 @@ void initial_hash(uint8_t *blockhash, argon2_context *context,
             context->pwdlen = 0;
         }
     }
+}
+
+void initial_hash_suffix(uint8_t *blockhash, blake2b_state *BlakeHash,
+                         argon2_context *context) {
+    uint8_t value[sizeof(uint32_t)];
+
+    if (NULL == context || NULL == blockhash || NULL == BlakeHash) {
+        return;
+    }
 
     store32(&value, context->saltlen);
-    blake2b_update(&BlakeHash, (const uint8_t *)&value, sizeof(value));
+    blake2b_update(BlakeHash, (const uint8_t *)&value, sizeof(value));
 
     if (context->salt != NULL) {
-        blake2b_update(&BlakeHash, (const uint8_t *)context->salt,
+        blake2b_update(BlakeHash, (const uint8_t *)context->salt,
                        context->saltlen);
     }
 
     store32(&value, context->secretlen);
-    blake2b_update(&BlakeHash, (const uint8_t *)&value, sizeof(value));
+    blake2b_update(BlakeHash, (const uint8_t *)&value, sizeof(value));
 
     if (context->secret != NULL) {
-        blake2b_update(&BlakeHash, (const uint8_t *)context->secret,
+        blake2b_update(BlakeHash, (const uint8_t *)context->secret,
                        context->secretlen);
 
         if (context->flags & ARGON2_FLAG_CLEAR_SECRET) {
@@ -585,17 +747,35 @@ void initial_hash(uint8_t *blockhash, argon2_context *context,
     }
 
     store32(&value, context->adlen);
-    blake2b_update(&BlakeHash, (const uint8_t *)&value, sizeof(value));
+    blake2b_update(BlakeHash, (const uint8_t *)&value, sizeof(value));
 
     if (context->ad != NULL) {
-        blake2b_update(&BlakeHash, (const uint8_t *)context->ad,
+        blake2b_update(BlakeHash, (const uint8_t *)context->ad,
                        context->adlen);
     }
 
-    blake2b_final(&BlakeHash, blockhash, ARGON2_PREHASH_DIGEST_LENGTH);
+    blake2b_final(BlakeHash, blockhash, ARGON2_PREHASH_DIGEST_LENGTH);
+}
+
+void initial_hash(uint8_t *blockhash, argon2_context *context,
+                  argon2_type type) {
+    blake2b_state BlakeHash;
+
+    if (NULL == context || NULL == blockhash) {
+        return;
+    }
+
+    initial_hash_prefix(&BlakeHash, context, type);
+    initial_hash_suffix(blockhash, &BlakeHash, context);
 }
 
 int initialize(argon2_instance_t *instance, argon2_context *context) {
+    return initialize_with_prefix(instance, context, NULL);
+}
+
+int initialize_with_prefix(argon2_instance_t *instance,
+                           argon2_context *context,
+                           const blake2b_state *prefix) {
     uint8_t blockhash[ARGON2_PREHASH_SEED_LENGTH];
     int result = ARGON2_OK;
 
@@ -603,18 +783,27 @@ int initialize(argon2_instance_t *instance, argon2_context *context) {
         return ARGON2_INCORRECT_PARAMETER;
     instance->context_ptr = context;
 
-    /* 1. Memory allocation */
-    result = allocate_memory(context, (uint8_t **)&(instance->memory),
-                             instance->memory_blocks, sizeof(block));
-    if (result != ARGON2_OK) {
-        return result;
+    /* 1. Memory allocation, unless a reusable arena was handed in */
+    if (!instance->keep_memory) {
+        result = allocate_memory(context, (uint8_t **)&(instance->memory),
+                                 instance->memory_blocks, sizeof(block));
+        if (result != ARGON2_OK) {
+            return result;
+        }
     }
 
     /* 2. Initial hashing */
     /* H_0 + 8 extra bytes to produce the first blocks */
     /* uint8_t blockhash[ARGON2_PREHASH_SEED_LENGTH]; */
-    /* Hashing all inputs */
-    initial_hash(blockhash, context, instance->type);
+    /* Hashing all inputs, or only the salt onwards if the parameters and
+     * password were already absorbed */
+    if (prefix != NULL) {
+        blake2b_state BlakeHash = *prefix;
+        initial_hash_suffix(blockhash, &BlakeHash, context);
+        clear_internal_memory(&BlakeHash, sizeof(BlakeHash));
+    } else {
+        initial_hash(blockhash, context, instance->type);
+    }
     /* Zeroing 8 extra bytes */
     clear_internal_memory(blockhash + ARGON2_PREHASH_DIGEST_LENGTH,
                           ARGON2_PREHASH_SEED_LENGTH -
@@ -19,9 +19,15 @@
 #define ARGON2_CORE_H
 
 #include "argon2.h"
+#include "blake2/blake2.h"
 
 #define CONST_CAST(x) (x)(uintptr_t)
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||           \
+    defined(_M_IX86)
+#define ARGON2_X86
+#endif
+
 /**********************Argon2 internal constants*******************************/
 
 enum argon2_core_constants {
@@ -80,6 +86,10 @@ typedef struct Argon2_instance_t {
     argon2_type type;
     int print_internals; /* whether to print the memory blocks */
     argon2_context *context_ptr; /* points back to original context */
+    int keep_memory; /* memory is a reusable arena: neither allocated by
+                        initialize nor freed by finalize */
+    void *team;      /* persistent lane workers held across calls, or NULL */
+    argon2_kernel kernel; /* fill_block implementation used by fill_segment */
 } argon2_instance_t;
 
 /*
@@ -123,6 +133,34 @@ int allocate_memory(const argon2_context *context, uint8_t **memory,
 void free_memory(const argon2_context *context, uint8_t *memory,
                  size_t num, size_t size);
 
+/* Allocates @size bytes straight from the OS, asking for huge pages. The size
+ * may be rounded up; the mapped size is written back to @size and must be
+ * passed to free_pages.
+ * @param memory pointer to the pointer to the memory
+ * @param size requested size in bytes, updated to the mapped size
+ * @return ARGON2_OK if memory is allocated (with or without huge pages)
+ */
+int allocate_pages(uint8_t **memory, size_t *size);
+
+/* Releases memory obtained from allocate_pages, given either the requested
+ * or the mapped size. Does not wipe it. */
+void free_pages(uint8_t *memory, size_t size);
+
+/*
+ * Maps one arena of @blocks blocks for each of @members team members, each
+ * with allocate_pages. The arenas are separate mappings that nothing touches
+ * here, so the pages of each one are faulted in by the member that fills it
+ * and, on NUMA machines, come from that member's node.
+ * @param arenas Receives an array of @members arena pointers
+ * @return ARGON2_OK, or ARGON2_MEMORY_ALLOCATION_ERROR (nothing is left
+ * allocated then)
+ */
+int allocate_member_arenas(block ***arenas, uint32_t members, size_t blocks);
+
+/* Frees arenas from allocate_member_arenas, wiping them first if @wipe */
+void free_member_arenas(block **arenas, uint32_t members, size_t blocks,
+                        int wipe);
+
 /* Function that securely cleans the memory. This ignores any flags set
  * regarding clearing memory. Usually one just calls clear_internal_memory.
  * @param mem Pointer to the memory
@@ -137,6 +175,16 @@ void secure_wipe_memory(void *v, size_t n);
  */
 void clear_internal_memory(void *v, size_t n);
 
+/*
+ * Derives the memory layout of an instance (aligned block count, segment and
+ * lane lengths) from validated cost parameters. No memory is allocated.
+ * @param instance Instance to fill in
+ * @param context Validated context holding the cost parameters
+ * @param type Argon2 type
+ */
+void init_instance(argon2_instance_t *instance, const argon2_context *context,
+                   argon2_type type);
+
 /*
  * Computes absolute position of reference block in the lane following a skewed
  * distribution and using a pseudo-random value as input
@@ -173,6 +221,29 @@ int validate_inputs(const argon2_context *context);
 void initial_hash(uint8_t *blockhash, argon2_context *context,
                   argon2_type type);
 
+/*
+ * First half of initial_hash: absorbs the cost parameters, the type and the
+ * password into @BlakeHash, clearing the password if needed. The resulting
+ * state can be copied and finished with initial_hash_suffix for many salts.
+ * @param  BlakeHash State to initialize
+ * @param  context  Pointer to the Argon2 internal structure
+ * @param  type Argon2 type
+ */
+void initial_hash_prefix(blake2b_state *BlakeHash, argon2_context *context,
+                         argon2_type type);
+
+/*
+ * Second half of initial_hash: absorbs salt, secret and associated data into
+ * @BlakeHash, clears the secret if needed and writes the digest
+ * @param  blockhash Buffer for pre-hashing digest
+ * @param  BlakeHash State from initial_hash_prefix, consumed by the call
+ * @param  context  Pointer to the Argon2 internal structure
+ * @pre    @a blockhash must have at least @a PREHASH_DIGEST_LENGTH bytes
+ * allocated
+ */
+void initial_hash_suffix(uint8_t *blockhash, blake2b_state *BlakeHash,
+                         argon2_context *context);
+
 /*
  * Function creates first 2 blocks per lane
  * @param instance Pointer to the current instance
@@ -190,9 +261,21 @@ void fill_first_blocks(uint8_t *blockhash, const argon2_instance_t *instance);
  * @param  instance Current Argon2 instance
  * @return Zero if successful, -1 if memory failed to allocate. @context->state
  * will be modified if successful.
+ * @pre if @instance->keep_memory is set, @instance->memory must already point
+ * to memory_blocks blocks, which are reused instead of allocated
  */
 int initialize(argon2_instance_t *instance, argon2_context *context);
 
+/*
+ * Same as initialize, but starts the initial hash from @prefix, a state
+ * returned by initial_hash_prefix for the same parameters and password
+ * @param  prefix State to start from (copied, not modified), or NULL to hash
+ * everything like initialize does
+ */
+int initialize_with_prefix(argon2_instance_t *instance,
+                           argon2_context *context,
+                           const blake2b_state *prefix);
+
 /*
  * XORing the last block of each lane, hashing it, making the tag. Deallocates
  * the memory.
@@ -203,6 +286,7 @@ int initialize(argon2_instance_t *instance, argon2_context *context);
  * @pre context->out must point to outlen bytes of memory
  * @pre if context->free_cbk is not NULL, it should point to a function that
  * deallocates memory
+ * @pre memory is left in place if @instance->keep_memory is set
  */
 void finalize(const argon2_context *context, argon2_instance_t *instance);
 
@@ -217,6 +301,43 @@ void finalize(const argon2_context *context, argon2_instance_t *instance);
 void fill_segment(const argon2_instance_t *instance,
                   argon2_position_t position);
 
+/*
+ * fill_segment variants, one per fill_block kernel. fill_segment dispatches
+ * to the one named by @instance->kernel; the SIMD variants exist on x86 only.
+ */
+void fill_segment_ref(const argon2_instance_t *instance,
+                      argon2_position_t position);
+#if defined(ARGON2_X86)
+void fill_segment_sse2(const argon2_instance_t *instance,
+                       argon2_position_t position);
+void fill_segment_avx2(const argon2_instance_t *instance,
+                       argon2_position_t position);
+void fill_segment_avx512f(const argon2_instance_t *instance,
+                          argon2_position_t position);
+#endif
+
+/*
+ * Fills the segment at @position of @count instances in lockstep on the
+ * calling thread, interleaving their blocks
+ * @param instances Instances sharing passes, lanes, segment_length, type,
+ * version and kernel
+ * @param count Number of instances, at most ARGON2_MAX_INTERLEAVE
+ * @pre all block pointers must be valid
+ */
+void fill_segment_multi(const argon2_instance_t *const *instances,
+                        uint32_t count, argon2_position_t position);
+
+void fill_segment_multi_ref(const argon2_instance_t *const *instances,
+                            uint32_t count, argon2_position_t position);
+#if defined(ARGON2_X86)
+void fill_segment_multi_sse2(const argon2_instance_t *const *instances,
+                             uint32_t count, argon2_position_t position);
+void fill_segment_multi_avx2(const argon2_instance_t *const *instances,
+                             uint32_t count, argon2_position_t position);
+void fill_segment_multi_avx512f(const argon2_instance_t *const *instances,
+                                uint32_t count, argon2_position_t position);
+#endif
+
 /*
  * Function that fills the entire memory t_cost times based on the first two
  * blocks in each lane
@@ -225,4 +346,16 @@ void fill_segment(const argon2_instance_t *instance,
  */
 int fill_memory_blocks(argon2_instance_t *instance);
 
+/*
+ * Like fill_memory_blocks for @count independent instances at once, all on
+ * the calling thread: each segment is filled for every instance in lockstep
+ * so their memory latencies overlap
+ * @param instances Instances sharing passes, lanes, segment_length, type,
+ * version and kernel
+ * @param count Number of instances, at most ARGON2_MAX_INTERLEAVE
+ * @return ARGON2_OK if successful
+ */
+int fill_memory_blocks_interleaved(argon2_instance_t *const *instances,
+                                   uint32_t count);
+
 #endif
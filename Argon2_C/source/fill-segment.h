@@ -0,0 +1,243 @@
+/*
+ * Argon2 reference source code package - reference C implementations
+ *
+ * Copyright 2015
+ * Daniel Dinu, Dmitry Khovratovich, Jean-Philippe Aumasson, and Samuel Neves
+ *
+ * You may use this work under the terms of a Creative Commons CC0 1.0
+ * License/Waiver or the Apache Public License 2.0, at your option. The terms of
+ * these licenses can be found at:
+ *
+ * - CC0 1.0 Universal : http://creativecommons.org/publicdomain/zero/1.0
+ * - Apache 2.0        : http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * You should have received a copy of both of these licenses along with this
+ * software. If not, they may be obtained at the above URLs.
+ */
+
+/*
+ * Segment filling shared by all fill_block kernels. A kernel file defines
+ *   ARGON2_STATE_TYPE   element type of the working state
+ *   ARGON2_STATE_WORDS  number of elements making up one block
+ *   ARGON2_FILL_SEGMENT name of the fill_segment variant to emit
+ *   ARGON2_FILL_SEGMENT_MULTI name of the interleaved variant to emit
+ * and a static fill_block(ARGON2_STATE_TYPE *state, const block *ref_block,
+ * block *next_block, int with_xor) before including this file once.
+ */
+
+#if !defined(ARGON2_STATE_TYPE) || !defined(ARGON2_STATE_WORDS) ||           \
+    !defined(ARGON2_FILL_SEGMENT) || !defined(ARGON2_FILL_SEGMENT_MULTI)
+#error "ARGON2_STATE_TYPE, ARGON2_STATE_WORDS, ARGON2_FILL_SEGMENT and ARGON2_FILL_SEGMENT_MULTI must be defined"
+#endif
+
+#if defined(__GNUC__)
+#define prefetch_line(p) __builtin_prefetch(p)
+#elif defined(_MSC_VER) && defined(ARGON2_X86)
+#include <xmmintrin.h>
+#define prefetch_line(p) _mm_prefetch((const char *)(p), _MM_HINT_T0)
+#else
+#define prefetch_line(p) ((void)(p))
+#endif
+
+static void next_addresses(block *address_block, block *input_block) {
+    /*Temporary zero-initialized blocks*/
+    ARGON2_STATE_TYPE zero_block[ARGON2_STATE_WORDS];
+    ARGON2_STATE_TYPE zero2_block[ARGON2_STATE_WORDS];
+
+    memset(zero_block, 0, sizeof(zero_block));
+    memset(zero2_block, 0, sizeof(zero2_block));
+
+    /*Increasing index counter*/
+    input_block->v[6]++;
+
+    /*First iteration of G*/
+    fill_block(zero_block, input_block, address_block, 0);
+
+    /*Second iteration of G*/
+    fill_block(zero2_block, address_block, address_block, 0);
+}
+
+/* Where one instance stands in the segment being filled */
+typedef struct segment_cursor_t {
+    ARGON2_STATE_TYPE state[ARGON2_STATE_WORDS]; /* copy of the last block */
+    block address_block, input_block;
+    uint32_t prev_offset, curr_offset;
+    int data_independent_addressing;
+} segment_cursor_t;
+
+/*
+ * Prepares @cursor for filling the segment at @position
+ * @return index of the first block to fill in the segment
+ */
+static uint32_t segment_begin(const argon2_instance_t *instance,
+                              argon2_position_t position,
+                              segment_cursor_t *cursor) {
+    uint32_t starting_index;
+
+    cursor->data_independent_addressing =
+        (instance->type == Argon2_i) ||
+        (instance->type == Argon2_id && (position.pass == 0) &&
+         (position.slice < ARGON2_SYNC_POINTS / 2));
+
+    if (cursor->data_independent_addressing) {
+        init_block_value(&cursor->input_block, 0);
+
+        cursor->input_block.v[0] = position.pass;
+        cursor->input_block.v[1] = position.lane;
+        cursor->input_block.v[2] = position.slice;
+        cursor->input_block.v[3] = instance->memory_blocks;
+        cursor->input_block.v[4] = instance->passes;
+        cursor->input_block.v[5] = instance->type;
+    }
+
+    starting_index = 0;
+
+    if ((0 == position.pass) && (0 == position.slice)) {
+        starting_index = 2; /* we have already generated the first two blocks */
+
+        /* Don't forget to generate the first block of addresses: */
+        if (cursor->data_independent_addressing) {
+            next_addresses(&cursor->address_block, &cursor->input_block);
+        }
+    }
+
+    /* Offset of the current block */
+    cursor->curr_offset = position.lane * instance->lane_length +
+                          position.slice * instance->segment_length +
+                          starting_index;
+
+    if (0 == cursor->curr_offset % instance->lane_length) {
+        /* Last block in this lane */
+        cursor->prev_offset = cursor->curr_offset + instance->lane_length - 1;
+    } else {
+        /* Previous block */
+        cursor->prev_offset = cursor->curr_offset - 1;
+    }
+
+    memcpy(cursor->state, ((instance->memory + cursor->prev_offset)->v),
+           ARGON2_BLOCK_SIZE);
+
+    return starting_index;
+}
+
+/*
+ * Finds the reference block for block @i of the segment, the one at
+ * @cursor->curr_offset. The previous block must already be filled.
+ */
+static block *segment_ref_block(const argon2_instance_t *instance,
+                                argon2_position_t *position,
+                                segment_cursor_t *cursor, uint32_t i) {
+    uint64_t pseudo_rand, ref_index, ref_lane;
+
+    /*1.1 Rotating prev_offset if needed */
+    if (cursor->curr_offset % instance->lane_length == 1) {
+        cursor->prev_offset = cursor->curr_offset - 1;
+    }
+
+    /* 1.2 Computing the index of the reference block */
+    /* 1.2.1 Taking pseudo-random value from the previous block */
+    if (cursor->data_independent_addressing) {
+        if (i % ARGON2_ADDRESSES_IN_BLOCK == 0) {
+            next_addresses(&cursor->address_block, &cursor->input_block);
+        }
+        pseudo_rand = cursor->address_block.v[i % ARGON2_ADDRESSES_IN_BLOCK];
+    } else {
+        pseudo_rand = instance->memory[cursor->prev_offset].v[0];
+    }
+
+    /* 1.2.2 Computing the lane of the reference block */
+    ref_lane = ((pseudo_rand >> 32)) % instance->lanes;
+
+    if ((position->pass == 0) && (position->slice == 0)) {
+        /* Can not reference other lanes yet */
+        ref_lane = position->lane;
+    }
+
+    /* 1.2.3 Computing the number of possible reference block within the
+     * lane.
+     */
+    position->index = i;
+    ref_index = index_alpha(instance, position, pseudo_rand & 0xFFFFFFFF,
+                            ref_lane == position->lane);
+
+    return instance->memory + instance->lane_length * ref_lane + ref_index;
+}
+
+/* version 1.2.1 and earlier overwrite blocks on later passes, not XOR */
+static int segment_with_xor(const argon2_instance_t *instance,
+                            argon2_position_t position) {
+    return ARGON2_VERSION_10 != instance->version && 0 != position.pass;
+}
+
+void ARGON2_FILL_SEGMENT(const argon2_instance_t *instance,
+                         argon2_position_t position) {
+    segment_cursor_t cursor;
+    uint32_t starting_index, i;
+    int with_xor;
+
+    if (instance == NULL) {
+        return;
+    }
+
+    starting_index = segment_begin(instance, position, &cursor);
+    with_xor = segment_with_xor(instance, position);
+
+    for (i = starting_index; i < instance->segment_length;
+         ++i, ++cursor.curr_offset, ++cursor.prev_offset) {
+        block *ref_block =
+            segment_ref_block(instance, &position, &cursor, i);
+
+        /* 2 Creating a new block */
+        fill_block(cursor.state, ref_block,
+                   instance->memory + cursor.curr_offset, with_xor);
+    }
+}
+
+/*
+ * Fills the same segment of up to ARGON2_MAX_INTERLEAVE instances of equal
+ * geometry in lockstep. As soon as an instance's block is done, the
+ * reference block of its next one is looked up and prefetched; the other
+ * instances' blocks are computed while it arrives, hiding the load latency
+ * a lone data-dependent Argon2d chain stalls on.
+ */
+void ARGON2_FILL_SEGMENT_MULTI(const argon2_instance_t *const *instances,
+                               uint32_t count, argon2_position_t position) {
+    segment_cursor_t cursors[ARGON2_MAX_INTERLEAVE];
+    block *ref_blocks[ARGON2_MAX_INTERLEAVE];
+    uint32_t starting_index = 0, i, j, k;
+    int with_xor;
+
+    if (instances == NULL || count == 0 || count > ARGON2_MAX_INTERLEAVE) {
+        return;
+    }
+
+    with_xor = segment_with_xor(instances[0], position);
+
+    for (j = 0; j < count; j++) {
+        starting_index = segment_begin(instances[j], position, &cursors[j]);
+        if (starting_index < instances[j]->segment_length) {
+            ref_blocks[j] = segment_ref_block(instances[j], &position,
+                                              &cursors[j], starting_index);
+        }
+    }
+
+    for (i = starting_index; i < instances[0]->segment_length; ++i) {
+        for (j = 0; j < count; j++) {
+            const argon2_instance_t *instance = instances[j];
+            segment_cursor_t *cursor = &cursors[j];
+
+            fill_block(cursor->state, ref_blocks[j],
+                       instance->memory + cursor->curr_offset, with_xor);
+            ++cursor->curr_offset;
+            ++cursor->prev_offset;
+
+            if (i + 1 < instance->segment_length) {
+                ref_blocks[j] =
+                    segment_ref_block(instance, &position, cursor, i + 1);
+                for (k = 0; k < ARGON2_BLOCK_SIZE; k += 64) {
+                    prefetch_line((const uint8_t *)ref_blocks[j]->v + k);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,203 @@
+/*
+ * Argon2 reference source code package - reference C implementations
+ *
+ * Copyright 2015
+ * Daniel Dinu, Dmitry Khovratovich, Jean-Philippe Aumasson, and Samuel Neves
+ *
+ * You may use this work under the terms of a Creative Commons CC0 1.0
+ * License/Waiver or the Apache Public License 2.0, at your option. The terms of
+ * these licenses can be found at:
+ *
+ * - CC0 1.0 Universal : http://creativecommons.org/publicdomain/zero/1.0
+ * - Apache 2.0        : http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * You should have received a copy of both of these licenses along with this
+ * software. If not, they may be obtained at the above URLs.
+ */
+
+/*
+ * Runtime selection of the fill_block kernel. Every kernel is compiled into
+ * the library and the best one the CPU (and OS) can run is picked the first
+ * time it is needed, so a single binary runs everywhere at full speed.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "argon2.h"
+#include "core.h"
+
+#if defined(ARGON2_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+/* Kernel forced through argon2_set_kernel, ARGON2_KERNEL_AUTO if none */
+static volatile int requested_kernel = ARGON2_KERNEL_AUTO;
+/* Best kernel the CPU supports, ARGON2_KERNEL_AUTO until detected */
+static volatile int detected_kernel = ARGON2_KERNEL_AUTO;
+/* Instances filled together by the batch and proof-of-work paths */
+static volatile uint32_t interleave = ARGON2_DEFAULT_INTERLEAVE;
+
+#if defined(ARGON2_X86)
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)subleaf);
+    regs[0] = (uint32_t)r[0];
+    regs[1] = (uint32_t)r[1];
+    regs[2] = (uint32_t)r[2];
+    regs[3] = (uint32_t)r[3];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/* Register state the OS saves on context switch (XCR0) */
+static uint64_t xgetbv0(void) {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+static argon2_kernel detect_kernel(void) {
+    uint32_t regs[4];
+    uint32_t max_leaf, leaf1_ecx, leaf1_edx, leaf7_ebx = 0;
+    uint64_t xcr0 = 0;
+
+    cpuid(0, 0, regs);
+    max_leaf = regs[0];
+    if (max_leaf < 1) {
+        return ARGON2_KERNEL_REF;
+    }
+
+    cpuid(1, 0, regs);
+    leaf1_ecx = regs[2];
+    leaf1_edx = regs[3];
+    if (max_leaf >= 7) {
+        cpuid(7, 0, regs);
+        leaf7_ebx = regs[1];
+    }
+    if (leaf1_ecx & (1u << 27)) { /* OSXSAVE */
+        xcr0 = xgetbv0();
+    }
+
+    /* AVX-512F needs the OS to save XMM, YMM, opmask and both ZMM halves */
+    if ((leaf7_ebx & (1u << 16)) && (xcr0 & 0xE6) == 0xE6) {
+        return ARGON2_KERNEL_AVX512F;
+    }
+    /* AVX2 needs the OS to save XMM and YMM */
+    if ((leaf7_ebx & (1u << 5)) && (xcr0 & 0x6) == 0x6) {
+        return ARGON2_KERNEL_AVX2;
+    }
+    if (leaf1_edx & (1u << 26)) {
+        return ARGON2_KERNEL_SSE2;
+    }
+    return ARGON2_KERNEL_REF;
+}
+#else
+static argon2_kernel detect_kernel(void) { return ARGON2_KERNEL_REF; }
+#endif
+
+/* Kernels rank REF < SSE2 < AVX2 < AVX512F and each CPU level implies the
+ * ones below it, so a kernel is usable if it does not exceed the detected
+ * one. */
+static argon2_kernel best_kernel(void) {
+    if (detected_kernel == ARGON2_KERNEL_AUTO) {
+        detected_kernel = detect_kernel();
+    }
+    return (argon2_kernel)detected_kernel;
+}
+
+argon2_kernel argon2_get_kernel(void) {
+    argon2_kernel kernel = (argon2_kernel)requested_kernel;
+
+    if (kernel == ARGON2_KERNEL_AUTO) {
+        kernel = best_kernel();
+    }
+    return kernel;
+}
+
+int argon2_set_kernel(argon2_kernel kernel) {
+    if (kernel < ARGON2_KERNEL_AUTO || kernel > ARGON2_KERNEL_AVX512F ||
+        kernel > best_kernel()) {
+        return ARGON2_KERNEL_UNSUPPORTED;
+    }
+    requested_kernel = kernel;
+    return ARGON2_OK;
+}
+
+const char *argon2_kernel2string(argon2_kernel kernel) {
+    switch (kernel) {
+    case ARGON2_KERNEL_AUTO:
+        return "auto";
+    case ARGON2_KERNEL_REF:
+        return "ref";
+    case ARGON2_KERNEL_SSE2:
+        return "sse2";
+    case ARGON2_KERNEL_AVX2:
+        return "avx2";
+    case ARGON2_KERNEL_AVX512F:
+        return "avx512f";
+    }
+
+    return NULL;
+}
+
+uint32_t argon2_get_interleave(void) { return interleave; }
+
+int argon2_set_interleave(uint32_t ways) {
+    if (ways == 0 || ways > ARGON2_MAX_INTERLEAVE) {
+        return ARGON2_INCORRECT_PARAMETER;
+    }
+    interleave = ways;
+    return ARGON2_OK;
+}
+
+void fill_segment(const argon2_instance_t *instance,
+                  argon2_position_t position) {
+    switch (instance->kernel) {
+#if defined(ARGON2_X86)
+    case ARGON2_KERNEL_AVX512F:
+        fill_segment_avx512f(instance, position);
+        break;
+    case ARGON2_KERNEL_AVX2:
+        fill_segment_avx2(instance, position);
+        break;
+    case ARGON2_KERNEL_SSE2:
+        fill_segment_sse2(instance, position);
+        break;
+#endif
+    default:
+        fill_segment_ref(instance, position);
+        break;
+    }
+}
+
+void fill_segment_multi(const argon2_instance_t *const *instances,
+                        uint32_t count, argon2_position_t position) {
+    switch (instances[0]->kernel) {
+#if defined(ARGON2_X86)
+    case ARGON2_KERNEL_AVX512F:
+        fill_segment_multi_avx512f(instances, count, position);
+        break;
+    case ARGON2_KERNEL_AVX2:
+        fill_segment_multi_avx2(instances, count, position);
+        break;
+    case ARGON2_KERNEL_SSE2:
+        fill_segment_multi_sse2(instances, count, position);
+        break;
+#endif
+    default:
+        fill_segment_multi_ref(instances, count, position);
+        break;
+    }
+}
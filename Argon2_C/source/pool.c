@@ -0,0 +1,241 @@
+/*
+ * Argon2 reference source code package - reference C implementations
+ *
+ * Copyright 2015
+ * Daniel Dinu, Dmitry Khovratovich, Jean-Philippe Aumasson, and Samuel Neves
+ *
+ * You may use this work under the terms of a Creative Commons CC0 1.0
+ * License/Waiver or the Apache Public License 2.0, at your option. The terms of
+ * these licenses can be found at:
+ *
+ * - CC0 1.0 Universal : http://creativecommons.org/publicdomain/zero/1.0
+ * - Apache 2.0        : http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * You should have received a copy of both of these licenses along with this
+ * software. If not, they may be obtained at the above URLs.
+ */
+
+#if !defined(ARGON2_NO_THREADS)
+
+#include <stdlib.h>
+
+#include "pool.h"
+#include "thread.h"
+
+struct Argon2_team_t {
+    argon2_mutex_t lock;
+    argon2_cond_t start_cond; /* signalled when a new job is posted */
+    argon2_cond_t done_cond;  /* signalled when the last worker is done */
+    argon2_thread_handle_t *threads;
+    struct Argon2_team_worker_t *worker_data;
+    uint32_t workers;    /* pool threads, i.e. members besides the caller */
+    uint32_t members;    /* members taking part in the jobs of the holder */
+    argon2_team_func_t func;
+    void *arg;
+    uint32_t generation; /* bumped every time a job is posted */
+    uint32_t pending;    /* workers still running the current job */
+    int shutdown;
+    argon2_team_t *next; /* free list link */
+};
+
+typedef struct Argon2_team_worker_t {
+    argon2_team_t *team;
+    uint32_t member;
+} argon2_team_worker_t;
+
+/* Teams that are not currently held by any caller */
+static argon2_mutex_t pool_lock = ARGON2_MUTEX_INITIALIZER;
+static argon2_team_t *pool_free = NULL;
+
+#ifdef _WIN32
+static unsigned __stdcall team_worker_thr(void *worker_data)
+#else
+static void *team_worker_thr(void *worker_data)
+#endif
+{
+    argon2_team_worker_t *my_data = worker_data;
+    argon2_team_t *team = my_data->team;
+    uint32_t seen = 0;
+
+    argon2_mutex_lock(&team->lock);
+    for (;;) {
+        while (!team->shutdown && team->generation == seen) {
+            argon2_cond_wait(&team->start_cond, &team->lock);
+        }
+        if (team->shutdown) {
+            break;
+        }
+        seen = team->generation;
+
+        /* Smaller jobs than the team size leave the upper workers idle */
+        if (my_data->member < team->members) {
+            argon2_team_func_t func = team->func;
+            void *arg = team->arg;
+
+            argon2_mutex_unlock(&team->lock);
+            func(arg, my_data->member);
+            argon2_mutex_lock(&team->lock);
+
+            if (--team->pending == 0) {
+                argon2_cond_broadcast(&team->done_cond);
+            }
+        }
+    }
+    argon2_mutex_unlock(&team->lock);
+
+    argon2_thread_exit();
+    return 0;
+}
+
+/* Stops and joins the first @started workers of @team and frees it */
+static void team_destroy(argon2_team_t *team, uint32_t started) {
+    uint32_t i;
+
+    argon2_mutex_lock(&team->lock);
+    team->shutdown = 1;
+    argon2_cond_broadcast(&team->start_cond);
+    argon2_mutex_unlock(&team->lock);
+
+    for (i = 0; i < started; ++i) {
+        argon2_thread_join(team->threads[i]);
+    }
+
+    argon2_cond_destroy(&team->done_cond);
+    argon2_cond_destroy(&team->start_cond);
+    argon2_mutex_destroy(&team->lock);
+    free(team->worker_data);
+    free(team->threads);
+    free(team);
+}
+
+static int team_create(argon2_team_t **team, uint32_t workers) {
+    argon2_team_t *t;
+    uint32_t i;
+
+    t = calloc(1, sizeof(argon2_team_t));
+    if (t == NULL) {
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+
+    t->threads = calloc(workers, sizeof(argon2_thread_handle_t));
+    t->worker_data = calloc(workers, sizeof(argon2_team_worker_t));
+    if (t->threads == NULL || t->worker_data == NULL) {
+        free(t->threads);
+        free(t->worker_data);
+        free(t);
+        return ARGON2_MEMORY_ALLOCATION_ERROR;
+    }
+
+    if (argon2_mutex_init(&t->lock) != 0 ||
+        argon2_cond_init(&t->start_cond) != 0 ||
+        argon2_cond_init(&t->done_cond) != 0) {
+        free(t->threads);
+        free(t->worker_data);
+        free(t);
+        return ARGON2_THREAD_FAIL;
+    }
+    t->workers = workers;
+
+    for (i = 0; i < workers; ++i) {
+        t->worker_data[i].team = t;
+        t->worker_data[i].member = i + 1;
+        if (argon2_thread_create(&t->threads[i], &team_worker_thr,
+                                 (void *)&t->worker_data[i])) {
+            team_destroy(t, i);
+            return ARGON2_THREAD_FAIL;
+        }
+    }
+
+    *team = t;
+    return ARGON2_OK;
+}
+
+int argon2_team_acquire(argon2_team_t **team, uint32_t members) {
+    argon2_team_t **it, **best = NULL;
+    argon2_team_t *t = NULL;
+
+    if (team == NULL || members == 0) {
+        return ARGON2_INCORRECT_PARAMETER;
+    }
+
+    /* Take the smallest free team that is big enough */
+    argon2_mutex_lock(&pool_lock);
+    for (it = &pool_free; *it != NULL; it = &(*it)->next) {
+        if ((*it)->workers + 1 >= members &&
+            (best == NULL || (*it)->workers < (*best)->workers)) {
+            best = it;
+        }
+    }
+    if (best != NULL) {
+        t = *best;
+        *best = t->next;
+    }
+    argon2_mutex_unlock(&pool_lock);
+
+    if (t == NULL) {
+        int rc = team_create(&t, members - 1);
+        if (rc != ARGON2_OK) {
+            return rc;
+        }
+    }
+
+    t->next = NULL;
+    t->members = members;
+    *team = t;
+    return ARGON2_OK;
+}
+
+void argon2_team_run(argon2_team_t *team, argon2_team_func_t func, void *arg) {
+    if (team->members > 1) {
+        argon2_mutex_lock(&team->lock);
+        team->func = func;
+        team->arg = arg;
+        team->pending = team->members - 1;
+        team->generation++;
+        argon2_cond_broadcast(&team->start_cond);
+        argon2_mutex_unlock(&team->lock);
+    }
+
+    func(arg, 0);
+
+    if (team->members > 1) {
+        argon2_mutex_lock(&team->lock);
+        while (team->pending != 0) {
+            argon2_cond_wait(&team->done_cond, &team->lock);
+        }
+        argon2_mutex_unlock(&team->lock);
+    }
+}
+
+void argon2_team_release(argon2_team_t *team) {
+    if (team == NULL) {
+        return;
+    }
+    argon2_mutex_lock(&pool_lock);
+    team->next = pool_free;
+    pool_free = team;
+    argon2_mutex_unlock(&pool_lock);
+}
+
+void argon2_pool_shutdown(void) {
+    argon2_team_t *team;
+
+    argon2_mutex_lock(&pool_lock);
+    team = pool_free;
+    pool_free = NULL;
+    argon2_mutex_unlock(&pool_lock);
+
+    while (team != NULL) {
+        argon2_team_t *next = team->next;
+        team_destroy(team, team->workers);
+        team = next;
+    }
+}
+
+#else /* ARGON2_NO_THREADS */
+
+#include "argon2.h"
+
+void argon2_pool_shutdown(void) {}
+
+#endif /* ARGON2_NO_THREADS */
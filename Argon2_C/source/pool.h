@@ -0,0 +1,68 @@
+/*
+ * Argon2 reference source code package - reference C implementations
+ *
+ * Copyright 2015
+ * Daniel Dinu, Dmitry Khovratovich, Jean-Philippe Aumasson, and Samuel Neves
+ *
+ * You may use this work under the terms of a Creative Commons CC0 1.0
+ * License/Waiver or the Apache Public License 2.0, at your option. The terms of
+ * these licenses can be found at:
+ *
+ * - CC0 1.0 Universal : http://creativecommons.org/publicdomain/zero/1.0
+ * - Apache 2.0        : http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * You should have received a copy of both of these licenses along with this
+ * software. If not, they may be obtained at the above URLs.
+ */
+
+#ifndef ARGON2_POOL_H
+#define ARGON2_POOL_H
+
+#if !defined(ARGON2_NO_THREADS)
+
+#include "argon2.h"
+
+/*
+        Persistent worker teams. Creating and joining one thread per lane for
+        every segment costs more than filling the segment itself for small
+        m_cost (the miner hashes 1 MiB with 2 lanes), so the threads are
+        created once and kept parked on a condition variable between jobs.
+
+        A team has a fixed number of members. Member 0 is always the calling
+        thread; members 1..N-1 are pool threads. argon2_team_run() hands the
+        same job to every member and returns once all of them are done, which
+        gives the barrier we need at each slice boundary.
+
+        Teams live on a global free list and are reused across argon2_ctx
+        calls, so concurrent callers (several miner threads) each get their
+        own team without stepping on each other.
+*/
+
+typedef struct Argon2_team_t argon2_team_t;
+
+/* Job run by every member of a team
+ * @param arg Job argument passed to argon2_team_run
+ * @param member Index of the member, 0..members-1
+ */
+typedef void (*argon2_team_func_t)(void *arg, uint32_t member);
+
+/* Takes a team with @members members from the pool, creating or growing one
+ * if none is free
+ * @param team Receives the team. Must not be NULL.
+ * @param members Number of members, including the calling thread. Must be at
+ * least 1.
+ * @return ARGON2_OK on success, ARGON2_MEMORY_ALLOCATION_ERROR or
+ * ARGON2_THREAD_FAIL otherwise
+ */
+int argon2_team_acquire(argon2_team_t **team, uint32_t members);
+
+/* Runs @func on every member of @team and waits for all of them to finish.
+ * The calling thread runs member 0.
+ */
+void argon2_team_run(argon2_team_t *team, argon2_team_func_t func, void *arg);
+
+/* Returns @team to the pool for later reuse */
+void argon2_team_release(argon2_team_t *team);
+
+#endif /* ARGON2_NO_THREADS */
+#endif
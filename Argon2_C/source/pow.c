@@ -0,0 +1,591 @@
+/*
+ * Argon2 reference source code package - reference C implementations
+ *
+ * Copyright 2015
+ * Daniel Dinu, Dmitry Khovratovich, Jean-Philippe Aumasson, and Samuel Neves
+ *
+ * You may use this work under the terms of a Creative Commons CC0 1.0
+ * License/Waiver or the Apache Public License 2.0, at your option. The terms of
+ * these licenses can be found at:
+ *
+ * - CC0 1.0 Universal : http://creativecommons.org/publicdomain/zero/1.0
+ * - Apache 2.0        : http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * You should have received a copy of both of these licenses along with this
+ * software. If not, they may be obtained at the above URLs.
+ */
+
+/*
+ * Proof-of-work nonce search. The managed miner used to hash one nonce per
+ * call and compare it against the difficulty target itself; running the
+ * whole loop here removes the per-hash marshalling and lets the hashes reuse
+ * one arena and one pre-hashed challenge. Solutions seen on the network are
+ * checked here in batches as well, spread over the worker pool.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "argon2.h"
+#include "core.h"
+#include "pool.h"
+#include "thread.h"
+
+/* Shared state of one argon2_pow_search call */
+typedef struct Argon2_pow_job {
+    argon2_instance_t instance; /* layout shared by all members */
+    argon2_context context;     /* parameters and challenge */
+    blake2b_state prefix;       /* initial hash state up to the challenge */
+    block **arenas;             /* per member, ways instances each */
+    uint8_t *nonce;             /* first nonce, receives the solution */
+    const uint8_t *hash_ceil;
+    size_t ceillen;
+    uint8_t *hash;              /* receives the hash of the solution */
+    const volatile int32_t *cancel;
+    uint64_t deadline;          /* in now_ms() time, 0 for none */
+    volatile int64_t *hash_counter;
+    uint32_t members;
+    uint32_t ways;              /* nonces filled together by one member */
+    uint64_t rounds;            /* most nonce groups tried by any member */
+    int found;
+#if !defined(ARGON2_NO_THREADS)
+    argon2_mutex_t lock;        /* guards rounds, found, nonce and hash */
+#endif
+} argon2_pow_job;
+
+static uint64_t now_ms(void) {
+#if defined(_WIN32)
+    return GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+#endif
+}
+
+static void counter_add(volatile int64_t *counter, int64_t value) {
+    if (counter == NULL) {
+        return;
+    }
+#if defined(_WIN32)
+    InterlockedExchangeAdd64((volatile LONG64 *)counter, value);
+#elif defined(__GNUC__) || defined(__clang__)
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+#else
+    *counter += value;
+#endif
+}
+
+/* Adds @steps to the big-endian @nonce, leaving the first byte alone like
+ * the managed miner's nonce counter does */
+static void nonce_advance(uint8_t *nonce, size_t noncelen, uint64_t steps) {
+    size_t pos;
+    unsigned carry = 0;
+
+    for (pos = noncelen - 1; pos > 0 && (steps != 0 || carry != 0); pos--) {
+        unsigned sum = nonce[pos] + (unsigned)(steps & 0xFF) + carry;
+        nonce[pos] = (uint8_t)sum;
+        carry = sum >> 8;
+        steps >>= 8;
+    }
+}
+
+/* A hash passes if it is not above the ceiling, compared as a big-endian
+ * number; the ceiling is padded with 0xFF up to the hash length */
+static int hash_below_ceil(const uint8_t *hash, size_t hashlen,
+                           const uint8_t *hash_ceil, size_t ceillen) {
+    size_t i;
+
+    for (i = 0; i < hashlen; i++) {
+        uint8_t cb = i < ceillen ? hash_ceil[i] : 0xFF;
+        if (cb > hash[i]) {
+            return 1;
+        }
+        if (cb < hash[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void job_lock(argon2_pow_job *job) {
+#if !defined(ARGON2_NO_THREADS)
+    argon2_mutex_lock(&job->lock);
+#else
+    (void)job;
+#endif
+}
+
+static void job_unlock(argon2_pow_job *job) {
+#if !defined(ARGON2_NO_THREADS)
+    argon2_mutex_unlock(&job->lock);
+#else
+    (void)job;
+#endif
+}
+
+/* Member m tries groups of ways nonces starting at n + m * ways,
+ * n + (m + members) * ways, ..., filling each group in lockstep */
+static void pow_search_thr(void *job_data, uint32_t member) {
+    argon2_pow_job *job = job_data;
+    argon2_instance_t instances[ARGON2_MAX_INTERLEAVE];
+    argon2_instance_t *group[ARGON2_MAX_INTERLEAVE];
+    argon2_context contexts[ARGON2_MAX_INTERLEAVE];
+    uint8_t nonces[ARGON2_MAX_INTERLEAVE][ARGON2_POW_MAX_NONCE_LENGTH];
+    uint8_t hashes[ARGON2_MAX_INTERLEAVE][ARGON2_POW_MAX_HASH_LENGTH];
+    size_t noncelen = job->context.saltlen;
+    uint64_t rounds = 0;
+    uint32_t j;
+    int stop = 0;
+
+    for (j = 0; j < job->ways; j++) {
+        instances[j] = job->instance;
+        instances[j].memory =
+            job->arenas[member] + (size_t)j * job->instance.memory_blocks;
+        group[j] = &instances[j];
+
+        contexts[j] = job->context;
+        contexts[j].salt = nonces[j];
+        contexts[j].out = hashes[j];
+
+        memcpy(nonces[j], job->nonce, noncelen);
+        nonce_advance(nonces[j], noncelen, (uint64_t)member * job->ways + j);
+    }
+
+    while (!stop) {
+        for (j = 0; j < job->ways; j++) {
+            initialize_with_prefix(&instances[j], &contexts[j], &job->prefix);
+        }
+        fill_memory_blocks_interleaved(group, job->ways);
+        for (j = 0; j < job->ways; j++) {
+            finalize(&contexts[j], &instances[j]);
+        }
+        rounds++;
+        counter_add(job->hash_counter, job->ways);
+
+        job_lock(job);
+        for (j = 0; j < job->ways && !stop; j++) {
+            if (job->found) {
+                stop = 1;
+            } else if (hash_below_ceil(hashes[j], job->context.outlen,
+                                       job->hash_ceil, job->ceillen)) {
+                job->found = 1;
+                memcpy(job->nonce, nonces[j], noncelen);
+                memcpy(job->hash, hashes[j], job->context.outlen);
+                stop = 1;
+            }
+        }
+        if (rounds > job->rounds) {
+            job->rounds = rounds;
+        }
+        job_unlock(job);
+
+        if ((job->cancel != NULL && *job->cancel != 0) ||
+            (job->deadline != 0 && now_ms() >= job->deadline)) {
+            stop = 1;
+        }
+
+        for (j = 0; j < job->ways; j++) {
+            nonce_advance(nonces[j], noncelen,
+                          (uint64_t)job->members * job->ways);
+        }
+    }
+}
+
+int argon2_pow_search(const uint32_t t_cost, const uint32_t m_cost,
+                      const uint32_t parallelism, const void *pwd,
+                      const size_t pwdlen, void *nonce, const size_t noncelen,
+                      const void *hash_ceil, const size_t ceillen, void *hash,
+                      const size_t hashlen, const volatile int32_t *cancel,
+                      const uint32_t time_budget_ms,
+                      volatile int64_t *hash_counter, const uint32_t threads,
+                      argon2_type type) {
+    argon2_pow_job job;
+    int result;
+
+    if (nonce == NULL || hash == NULL || hash_ceil == NULL || threads == 0) {
+        return ARGON2_INCORRECT_PARAMETER;
+    }
+
+    if (noncelen > ARGON2_POW_MAX_NONCE_LENGTH) {
+        return ARGON2_SALT_TOO_LONG;
+    }
+
+    if (hashlen > ARGON2_POW_MAX_HASH_LENGTH) {
+        return ARGON2_OUTPUT_TOO_LONG;
+    }
+
+    if (pwdlen > ARGON2_MAX_PWD_LENGTH) {
+        return ARGON2_PWD_TOO_LONG;
+    }
+
+    if (Argon2_d != type && Argon2_i != type && Argon2_id != type) {
+        return ARGON2_INCORRECT_TYPE;
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.context.out = (uint8_t *)hash;
+    job.context.outlen = (uint32_t)hashlen;
+    job.context.pwd = CONST_CAST(uint8_t *)pwd;
+    job.context.pwdlen = (uint32_t)pwdlen;
+    job.context.salt = (uint8_t *)nonce;
+    job.context.saltlen = (uint32_t)noncelen;
+    job.context.t_cost = t_cost;
+    job.context.m_cost = m_cost;
+    job.context.lanes = parallelism;
+    job.context.threads = parallelism;
+    job.context.flags = ARGON2_DEFAULT_FLAGS;
+    job.context.version = ARGON2_VERSION_NUMBER;
+
+    result = validate_inputs(&job.context);
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+    /* Like argon2_hash_raw_batch: each member fills all lanes of its own
+     * hashes, so there are no slice barriers between the members */
+    init_instance(&job.instance, &job.context, type);
+    job.instance.threads = 1;
+    job.instance.keep_memory = 1;
+
+    job.nonce = (uint8_t *)nonce;
+    job.hash_ceil = (const uint8_t *)hash_ceil;
+    job.ceillen = ceillen;
+    job.hash = (uint8_t *)hash;
+    job.cancel = cancel;
+    job.deadline = time_budget_ms != 0 ? now_ms() + time_budget_ms : 0;
+    job.hash_counter = hash_counter;
+    job.members = threads;
+#if defined(ARGON2_NO_THREADS)
+    job.members = 1;
+#endif
+    job.ways = argon2_get_interleave();
+
+    /* The parameters and challenge are the same for every nonce */
+    initial_hash_prefix(&job.prefix, &job.context, type);
+
+    result = allocate_member_arenas(&job.arenas, job.members,
+                                    (size_t)job.ways *
+                                        job.instance.memory_blocks);
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+#if !defined(ARGON2_NO_THREADS)
+    if (argon2_mutex_init(&job.lock) != 0) {
+        free_member_arenas(job.arenas, job.members,
+                           (size_t)job.ways * job.instance.memory_blocks, 0);
+        return ARGON2_THREAD_FAIL;
+    }
+
+    if (job.members > 1) {
+        argon2_team_t *team = NULL;
+        result = argon2_team_acquire(&team, job.members);
+        if (ARGON2_OK == result) {
+            argon2_team_run(team, &pow_search_thr, &job);
+            argon2_team_release(team);
+        }
+    } else
+#endif
+    {
+        pow_search_thr(&job, 0);
+    }
+
+#if !defined(ARGON2_NO_THREADS)
+    argon2_mutex_destroy(&job.lock);
+#endif
+
+    /* The challenge and nonces are public, so the arenas are not wiped */
+    free_member_arenas(job.arenas, job.members,
+                       (size_t)job.ways * job.instance.memory_blocks, 0);
+
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+    if (!job.found) {
+        /* Continue after every nonce tried on the next call */
+        nonce_advance((uint8_t *)nonce, noncelen,
+                      job.rounds * job.members * job.ways);
+        return ARGON2_POW_NOT_FOUND;
+    }
+
+    return ARGON2_OK;
+}
+
+/* Shared state of one argon2_pow_verify_batch call */
+typedef struct Argon2_pow_verify_job {
+    argon2_instance_t instance; /* layout shared by all items */
+    argon2_context context;     /* parameters shared by all items */
+    block **arenas;             /* per member, ways instances each */
+    const uint8_t *challenges;
+    const size_t *challenge_lens;
+    const uint8_t *nonces;
+    const size_t *nonce_lens;
+    const uint8_t *hash_ceils;
+    size_t ceillen;
+    size_t count;
+    uint8_t *results;
+    uint32_t members;
+    uint32_t ways;              /* items filled together by one member */
+    int short_circuit;
+    size_t next;                /* first item nobody has taken yet */
+    size_t challenge_offset;    /* of item next in challenges */
+    size_t nonce_offset;        /* of item next in nonces */
+    int failed;
+#if !defined(ARGON2_NO_THREADS)
+    argon2_mutex_t lock;        /* guards next, the offsets, failed and results */
+#endif
+} argon2_pow_verify_job;
+
+static void verify_lock(argon2_pow_verify_job *job) {
+#if !defined(ARGON2_NO_THREADS)
+    argon2_mutex_lock(&job->lock);
+#else
+    (void)job;
+#endif
+}
+
+static void verify_unlock(argon2_pow_verify_job *job) {
+#if !defined(ARGON2_NO_THREADS)
+    argon2_mutex_unlock(&job->lock);
+#else
+    (void)job;
+#endif
+}
+
+/* Members take up to ways items at a time in order until none are left, or
+ * until any item fails in short-circuit mode */
+static void pow_verify_thr(void *job_data, uint32_t member) {
+    argon2_pow_verify_job *job = job_data;
+    argon2_instance_t instances[ARGON2_MAX_INTERLEAVE];
+    argon2_instance_t *group[ARGON2_MAX_INTERLEAVE];
+    argon2_context contexts[ARGON2_MAX_INTERLEAVE];
+    uint8_t hashes[ARGON2_MAX_INTERLEAVE][ARGON2_POW_MAX_HASH_LENGTH];
+    size_t items[ARGON2_MAX_INTERLEAVE];
+    int valid[ARGON2_MAX_INTERLEAVE];
+    uint32_t j, n, filled;
+
+    for (j = 0; j < job->ways; j++) {
+        instances[j] = job->instance;
+        instances[j].memory =
+            job->arenas[member] + (size_t)j * job->instance.memory_blocks;
+    }
+
+    for (;;) {
+        verify_lock(job);
+        n = 0;
+        if (!(job->short_circuit && job->failed)) {
+            while (n < job->ways && job->next < job->count) {
+                contexts[n] = job->context;
+                contexts[n].pwd = CONST_CAST(uint8_t *)(job->challenges +
+                                                        job->challenge_offset);
+                contexts[n].pwdlen = (uint32_t)job->challenge_lens[job->next];
+                contexts[n].salt =
+                    CONST_CAST(uint8_t *)(job->nonces + job->nonce_offset);
+                contexts[n].saltlen = (uint32_t)job->nonce_lens[job->next];
+                contexts[n].out = hashes[n];
+                items[n] = job->next;
+                job->challenge_offset += job->challenge_lens[job->next];
+                job->nonce_offset += job->nonce_lens[job->next];
+                job->next++;
+                n++;
+            }
+        }
+        verify_unlock(job);
+
+        if (n == 0) {
+            return;
+        }
+
+        /* Items with inputs Argon2 rejects simply fail */
+        filled = 0;
+        for (j = 0; j < n; j++) {
+            valid[j] =
+                job->challenge_lens[items[j]] <= ARGON2_MAX_PWD_LENGTH &&
+                job->nonce_lens[items[j]] <= ARGON2_MAX_SALT_LENGTH &&
+                ARGON2_OK == validate_inputs(&contexts[j]);
+            if (valid[j]) {
+                initialize_with_prefix(&instances[filled], &contexts[j], NULL);
+                group[filled] = &instances[filled];
+                filled++;
+            }
+        }
+
+        if (filled != 0) {
+            fill_memory_blocks_interleaved(group, filled);
+        }
+
+        filled = 0;
+        for (j = 0; j < n; j++) {
+            if (valid[j]) {
+                finalize(&contexts[j], &instances[filled++]);
+                valid[j] = hash_below_ceil(
+                    hashes[j], job->context.outlen,
+                    job->hash_ceils + items[j] * job->ceillen, job->ceillen);
+            }
+        }
+
+        verify_lock(job);
+        for (j = 0; j < n; j++) {
+            if (valid[j]) {
+                job->results[items[j] / 8] |= (uint8_t)(1 << (items[j] % 8));
+            } else {
+                job->failed = 1;
+            }
+        }
+        verify_unlock(job);
+    }
+}
+
+int argon2_pow_verify_batch(const uint32_t t_cost, const uint32_t m_cost,
+                            const uint32_t parallelism, const void *challenges,
+                            const size_t *challenge_lens, const void *nonces,
+                            const size_t *nonce_lens, const void *hash_ceils,
+                            const size_t ceillen, const size_t count,
+                            const size_t hashlen, uint8_t *results,
+                            const uint32_t threads, const uint32_t flags,
+                            argon2_type type) {
+    argon2_pow_verify_job job;
+    int result;
+
+    if (results == NULL || threads == 0 ||
+        (count != 0 && (challenges == NULL || challenge_lens == NULL ||
+                        nonces == NULL || nonce_lens == NULL ||
+                        hash_ceils == NULL))) {
+        return ARGON2_INCORRECT_PARAMETER;
+    }
+
+    if (hashlen > ARGON2_POW_MAX_HASH_LENGTH) {
+        return ARGON2_OUTPUT_TOO_LONG;
+    }
+
+    if (Argon2_d != type && Argon2_i != type && Argon2_id != type) {
+        return ARGON2_INCORRECT_TYPE;
+    }
+
+    memset(results, 0, (count + 7) / 8);
+    if (count == 0) {
+        return ARGON2_OK;
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.context.out = results; /* placeholder so the layout validates */
+    job.context.outlen = (uint32_t)hashlen;
+    job.context.salt = (uint8_t *)results;
+    job.context.saltlen = ARGON2_MIN_SALT_LENGTH;
+    job.context.t_cost = t_cost;
+    job.context.m_cost = m_cost;
+    job.context.lanes = parallelism;
+    job.context.threads = parallelism;
+    job.context.flags = ARGON2_DEFAULT_FLAGS;
+    job.context.version = ARGON2_VERSION_NUMBER;
+
+    result = validate_inputs(&job.context);
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+    /* Items are spread over the members, so each hash fills its lanes on a
+     * single thread without any slice barriers */
+    init_instance(&job.instance, &job.context, type);
+    job.instance.threads = 1;
+    job.instance.keep_memory = 1;
+
+    job.challenges = (const uint8_t *)challenges;
+    job.challenge_lens = challenge_lens;
+    job.nonces = (const uint8_t *)nonces;
+    job.nonce_lens = nonce_lens;
+    job.hash_ceils = (const uint8_t *)hash_ceils;
+    job.ceillen = ceillen;
+    job.count = count;
+    job.results = results;
+    job.short_circuit = (flags & ARGON2_POW_VERIFY_SHORT_CIRCUIT) != 0;
+    job.members = threads;
+    if (job.members > count) {
+        job.members = (uint32_t)count;
+    }
+#if defined(ARGON2_NO_THREADS)
+    job.members = 1;
+#endif
+    job.ways = argon2_get_interleave();
+    if (job.ways > (count + job.members - 1) / job.members) {
+        job.ways = (uint32_t)((count + job.members - 1) / job.members);
+    }
+
+    result = allocate_member_arenas(&job.arenas, job.members,
+                                    (size_t)job.ways *
+                                        job.instance.memory_blocks);
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+#if !defined(ARGON2_NO_THREADS)
+    if (argon2_mutex_init(&job.lock) != 0) {
+        free_member_arenas(job.arenas, job.members,
+                           (size_t)job.ways * job.instance.memory_blocks, 0);
+        return ARGON2_THREAD_FAIL;
+    }
+
+    if (job.members > 1) {
+        argon2_team_t *team = NULL;
+        result = argon2_team_acquire(&team, job.members);
+        if (ARGON2_OK == result) {
+            argon2_team_run(team, &pow_verify_thr, &job);
+            argon2_team_release(team);
+        }
+    } else
+#endif
+    {
+        pow_verify_thr(&job, 0);
+    }
+
+#if !defined(ARGON2_NO_THREADS)
+    argon2_mutex_destroy(&job.lock);
+#endif
+
+    /* The challenges and nonces are public, so the arenas are not wiped */
+    free_member_arenas(job.arenas, job.members,
+                       (size_t)job.ways * job.instance.memory_blocks, 0);
+
+    if (ARGON2_OK != result) {
+        return result;
+    }
+
+    return job.failed ? ARGON2_VERIFY_MISMATCH : ARGON2_OK;
+}
+
+int argon2id_pow_verify_batch(const uint32_t t_cost, const uint32_t m_cost,
+                              const uint32_t parallelism,
+                              const void *challenges,
+                              const size_t *challenge_lens, const void *nonces,
+                              const size_t *nonce_lens, const void *hash_ceils,
+                              const size_t ceillen, const size_t count,
+                              const size_t hashlen, uint8_t *results,
+                              const uint32_t threads, const uint32_t flags) {
+    return argon2_pow_verify_batch(t_cost, m_cost, parallelism, challenges,
+                                   challenge_lens, nonces, nonce_lens,
+                                   hash_ceils, ceillen, count, hashlen,
+                                   results, threads, flags, Argon2_id);
+}
+
+int argon2id_pow_search(const uint32_t t_cost, const uint32_t m_cost,
+                        const uint32_t parallelism, const void *pwd,
+                        const size_t pwdlen, void *nonce,
+                        const size_t noncelen, const void *hash_ceil,
+                        const size_t ceillen, void *hash, const size_t hashlen,
+                        const volatile int32_t *cancel,
+                        const uint32_t time_budget_ms,
+                        volatile int64_t *hash_counter,
+                        const uint32_t threads) {
+    return argon2_pow_search(t_cost, m_cost, parallelism, pwd, pwdlen, nonce,
+                             noncelen, hash_ceil, ceillen, hash, hashlen,
+                             cancel, time_budget_ms, hash_counter, threads,
+                             Argon2_id);
+}
@@ -0,0 +1,95 @@
+/*
+ * Argon2 reference source code package - reference C implementations
+ *
+ * Copyright 2015
+ * Daniel Dinu, Dmitry Khovratovich, Jean-Philippe Aumasson, and Samuel Neves
+ *
+ * You may use this work under the terms of a Creative Commons CC0 1.0
+ * License/Waiver or the Apache Public License 2.0, at your option. The terms of
+ * these licenses can be found at:
+ *
+ * - CC0 1.0 Universal : http://creativecommons.org/publicdomain/zero/1.0
+ * - Apache 2.0        : http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * You should have received a copy of both of these licenses along with this
+ * software. If not, they may be obtained at the above URLs.
+ */
+
+/*
+ * Portable fill_block kernel, used on non-x86 targets and as the fallback
+ * when no SIMD kernel is usable.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "argon2.h"
+#include "core.h"
+
+#include "blake2/blamka-round-ref.h"
+#include "blake2/blake2-impl.h"
+#include "blake2/blake2.h"
+
+/*
+ * Function fills a new memory block and optionally XORs the old block over the new one.
+ * Memory must be initialized.
+ * @param state Pointer to the just produced block. Content will be updated(!)
+ * @param ref_block Pointer to the reference block
+ * @param next_block Pointer to the block to be XORed over. May coincide with @ref_block
+ * @param with_xor Whether to XOR into the new block (1) or just overwrite (0)
+ * @pre all block pointers must be valid
+ */
+static void fill_block(uint64_t *state, const block *ref_block,
+                       block *next_block, int with_xor) {
+    uint64_t block_R[ARGON2_QWORDS_IN_BLOCK];
+    uint64_t block_tmp[ARGON2_QWORDS_IN_BLOCK];
+    unsigned int i;
+
+    for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++) {
+        block_R[i] = state[i] ^ ref_block->v[i];
+        block_tmp[i] = block_R[i];
+    }
+
+    if (with_xor) {
+        /* Saving the next block contents for XOR over */
+        for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++) {
+            block_tmp[i] ^= next_block->v[i];
+        }
+    }
+
+    /* Apply Blake2 on columns of 64-bit words: (0,1,...,15) , then
+       (16,17,..31)... finally (112,113,...127) */
+    for (i = 0; i < 8; ++i) {
+        BLAKE2_ROUND_NOMSG(
+            block_R[16 * i], block_R[16 * i + 1], block_R[16 * i + 2],
+            block_R[16 * i + 3], block_R[16 * i + 4], block_R[16 * i + 5],
+            block_R[16 * i + 6], block_R[16 * i + 7], block_R[16 * i + 8],
+            block_R[16 * i + 9], block_R[16 * i + 10], block_R[16 * i + 11],
+            block_R[16 * i + 12], block_R[16 * i + 13], block_R[16 * i + 14],
+            block_R[16 * i + 15]);
+    }
+
+    /* Apply Blake2 on rows of 64-bit words: (0,1,16,17,...112,113), then
+       (2,3,18,19,...,114,115).. finally (14,15,30,31,...,126,127) */
+    for (i = 0; i < 8; i++) {
+        BLAKE2_ROUND_NOMSG(
+            block_R[2 * i], block_R[2 * i + 1], block_R[2 * i + 16],
+            block_R[2 * i + 17], block_R[2 * i + 32], block_R[2 * i + 33],
+            block_R[2 * i + 48], block_R[2 * i + 49], block_R[2 * i + 64],
+            block_R[2 * i + 65], block_R[2 * i + 80], block_R[2 * i + 81],
+            block_R[2 * i + 96], block_R[2 * i + 97], block_R[2 * i + 112],
+            block_R[2 * i + 113]);
+    }
+
+    for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++) {
+        state[i] = block_tmp[i] ^ block_R[i];
+    }
+    memcpy(next_block->v, state, ARGON2_BLOCK_SIZE);
+}
+
+#define ARGON2_STATE_TYPE uint64_t
+#define ARGON2_STATE_WORDS ARGON2_QWORDS_IN_BLOCK
+#define ARGON2_FILL_SEGMENT fill_segment_ref
+#define ARGON2_FILL_SEGMENT_MULTI fill_segment_multi_ref
+#include "fill-segment.h"
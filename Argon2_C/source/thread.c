@@ -54,4 +54,70 @@ void argon2_thread_exit(void) {
 #endif
 }
 
+int argon2_mutex_init(argon2_mutex_t *mutex) {
+#if defined(_WIN32)
+    InitializeSRWLock(mutex);
+    return 0;
+#else
+    return pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+void argon2_mutex_destroy(argon2_mutex_t *mutex) {
+#if defined(_WIN32)
+    (void)mutex; /* SRW locks own no resources */
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+void argon2_mutex_lock(argon2_mutex_t *mutex) {
+#if defined(_WIN32)
+    AcquireSRWLockExclusive(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+void argon2_mutex_unlock(argon2_mutex_t *mutex) {
+#if defined(_WIN32)
+    ReleaseSRWLockExclusive(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+int argon2_cond_init(argon2_cond_t *cond) {
+#if defined(_WIN32)
+    InitializeConditionVariable(cond);
+    return 0;
+#else
+    return pthread_cond_init(cond, NULL);
+#endif
+}
+
+void argon2_cond_destroy(argon2_cond_t *cond) {
+#if defined(_WIN32)
+    (void)cond; /* condition variables own no resources */
+#else
+    pthread_cond_destroy(cond);
+#endif
+}
+
+void argon2_cond_wait(argon2_cond_t *cond, argon2_mutex_t *mutex) {
+#if defined(_WIN32)
+    SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+#else
+    pthread_cond_wait(cond, mutex);
+#endif
+}
+
+void argon2_cond_broadcast(argon2_cond_t *cond) {
+#if defined(_WIN32)
+    WakeAllConditionVariable(cond);
+#else
+    pthread_cond_broadcast(cond);
+#endif
+}
+
 #endif /* ARGON2_NO_THREADS */
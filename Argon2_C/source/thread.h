@@ -22,8 +22,9 @@
 
 /*
         Here we implement an abstraction layer for the simpĺe requirements
-        of the Argon2 code. We only require 3 primitives---thread creation,
-        joining, and termination---so full emulation of the pthreads API
+        of the Argon2 code. We only require thread creation, joining and
+        termination, plus a mutex and a condition variable for the
+        persistent lane workers---so full emulation of the pthreads API
         is unwarranted. Currently we wrap pthreads and Win32 threads.
 
         The API defines 2 types: the function pointer type,
@@ -32,12 +33,21 @@
 */
 #if defined(_WIN32)
 #include <process.h>
+#include <windows.h>
 typedef unsigned(__stdcall *argon2_thread_func_t)(void *);
 typedef uintptr_t argon2_thread_handle_t;
+typedef SRWLOCK argon2_mutex_t;
+typedef CONDITION_VARIABLE argon2_cond_t;
+#define ARGON2_MUTEX_INITIALIZER SRWLOCK_INIT
+#define ARGON2_COND_INITIALIZER CONDITION_VARIABLE_INIT
 #else
 #include <pthread.h>
 typedef void *(*argon2_thread_func_t)(void *);
 typedef pthread_t argon2_thread_handle_t;
+typedef pthread_mutex_t argon2_mutex_t;
+typedef pthread_cond_t argon2_cond_t;
+#define ARGON2_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#define ARGON2_COND_INITIALIZER PTHREAD_COND_INITIALIZER
 #endif
 
 /* Creates a thread
@@ -63,5 +73,41 @@ int argon2_thread_join(argon2_thread_handle_t handle);
 */
 void argon2_thread_exit(void);
 
+/*
+        Synchronization primitives used by the persistent lane workers (see
+        pool.h). Both types can be statically initialized with
+        ARGON2_MUTEX_INITIALIZER / ARGON2_COND_INITIALIZER; the init and
+        destroy functions are only needed for dynamically allocated ones.
+*/
+
+/* Initializes a mutex
+ * @return 0 on success
+ */
+int argon2_mutex_init(argon2_mutex_t *mutex);
+
+/* Releases the resources held by a mutex, which must be unlocked */
+void argon2_mutex_destroy(argon2_mutex_t *mutex);
+
+void argon2_mutex_lock(argon2_mutex_t *mutex);
+
+void argon2_mutex_unlock(argon2_mutex_t *mutex);
+
+/* Initializes a condition variable
+ * @return 0 on success
+ */
+int argon2_cond_init(argon2_cond_t *cond);
+
+/* Releases the resources held by a condition variable nobody waits on */
+void argon2_cond_destroy(argon2_cond_t *cond);
+
+/* Atomically releases @mutex and blocks until @cond is signalled. @mutex is
+ * locked again on return. Spurious wakeups are possible, so callers must
+ * re-check their predicate in a loop.
+ */
+void argon2_cond_wait(argon2_cond_t *cond, argon2_mutex_t *mutex);
+
+/* Wakes all threads blocked on @cond */
+void argon2_cond_broadcast(argon2_cond_t *cond);
+
 #endif /* ARGON2_NO_THREADS */
 #endif
@@ -0,0 +1,530 @@
+#include "IC_AES.h"
+#include <string.h>
+
+#ifdef IC_CPU_X86
+#include <immintrin.h>
+
+// As in IC_SHA512.cpp, the kernels are compiled for their own instruction set and only reached
+// through ic_aesni_desc, which ic_aes_desc hands out once ic_cpu_features reports AES-NI.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("aes,ssse3"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("aes,ssse3")
+#endif
+
+// The round constants of the key schedule, one per Nk words
+static const unsigned char ic_aes_rcon[10] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36 };
+
+// SubWord of w, and RotWord(SubWord(w)) if rotate; bytes in memory order
+static ulong32 ic_aes_sub_word(ulong32 w, bool rotate)
+{
+	__m128i t = _mm_aeskeygenassist_si128(_mm_set1_epi32((int)w), 0);
+	return (ulong32)_mm_cvtsi128_si32(rotate ? _mm_shuffle_epi32(t, 0x55) : t);
+}
+
+static int ic_aesni_setup(const unsigned char* key, int keylen, int num_rounds, symmetric_key* skey)
+{
+	LTC_ARGCHK(key != NULL);
+	LTC_ARGCHK(skey != NULL);
+
+	if (keylen != 16 && keylen != 24 && keylen != 32)
+	{
+		return CRYPT_INVALID_KEYSIZE;
+	}
+	int nk = keylen / 4;
+	int nr = nk + 6;
+	if (num_rounds != 0 && num_rounds != nr)
+	{
+		return CRYPT_INVALID_ROUNDS;
+	}
+	skey->rijndael.Nr = nr;
+
+	// The FIPS-197 expansion over words in memory order, which is the byte order AES-NI takes
+	ulong32* w = skey->rijndael.eK;
+	memcpy(w, key, keylen);
+	for (int i = nk; i < 4 * (nr + 1); i++)
+	{
+		ulong32 t = w[i - 1];
+		if (i % nk == 0)
+		{
+			t = ic_aes_sub_word(t, true) ^ ic_aes_rcon[i / nk - 1];
+		}
+		else if (nk == 8 && i % nk == 4)
+		{
+			t = ic_aes_sub_word(t, false);
+		}
+		w[i] = w[i - nk] ^ t;
+	}
+
+	// The equivalent inverse cipher: the round keys in reverse, InvMixColumns on all but the outer two
+	const __m128i* ek = (const __m128i*)skey->rijndael.eK;
+	__m128i* dk = (__m128i*)skey->rijndael.dK;
+	_mm_storeu_si128(dk, _mm_loadu_si128(ek + nr));
+	for (int i = 1; i < nr; i++)
+	{
+		_mm_storeu_si128(dk + i, _mm_aesimc_si128(_mm_loadu_si128(ek + nr - i)));
+	}
+	_mm_storeu_si128(dk + nr, _mm_loadu_si128(ek));
+	return CRYPT_OK;
+}
+
+// The next counter block after c, which holds the counter as a 128-bit little endian number whose
+// low half the caller keeps from wrapping; reverse gives the big endian block
+static __m128i ic_aesni_next_counter(__m128i* c, bool reverse)
+{
+	*c = _mm_add_epi64(*c, _mm_set_epi64x(0, 1));
+	return reverse ? _mm_shuffle_epi8(*c, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)) : *c;
+}
+
+// blocks from in to out, eight side by side while there are eight, which keeps eight aesenc in
+// flight. With ctr the blocks encrypted are the counters after *c and out is in xor their key stream.
+template <bool decrypt, bool ctr>
+static void ic_aesni_blocks(const unsigned char* in, unsigned char* out, unsigned long blocks, const symmetric_key* skey, __m128i* c, bool reverse)
+{
+	const __m128i* rk = (const __m128i*)(decrypt ? skey->rijndael.dK : skey->rijndael.eK);
+	int nr = skey->rijndael.Nr;
+	__m128i k, b0, b1, b2, b3, b4, b5, b6, b7;
+
+	for (; blocks >= 8; blocks -= 8, in += 128, out += 128)
+	{
+		if (ctr)
+		{
+			b0 = ic_aesni_next_counter(c, reverse);
+			b1 = ic_aesni_next_counter(c, reverse);
+			b2 = ic_aesni_next_counter(c, reverse);
+			b3 = ic_aesni_next_counter(c, reverse);
+			b4 = ic_aesni_next_counter(c, reverse);
+			b5 = ic_aesni_next_counter(c, reverse);
+			b6 = ic_aesni_next_counter(c, reverse);
+			b7 = ic_aesni_next_counter(c, reverse);
+		}
+		else
+		{
+			b0 = _mm_loadu_si128((const __m128i*)in);
+			b1 = _mm_loadu_si128((const __m128i*)(in + 16));
+			b2 = _mm_loadu_si128((const __m128i*)(in + 32));
+			b3 = _mm_loadu_si128((const __m128i*)(in + 48));
+			b4 = _mm_loadu_si128((const __m128i*)(in + 64));
+			b5 = _mm_loadu_si128((const __m128i*)(in + 80));
+			b6 = _mm_loadu_si128((const __m128i*)(in + 96));
+			b7 = _mm_loadu_si128((const __m128i*)(in + 112));
+		}
+		k = _mm_loadu_si128(rk);
+		b0 = _mm_xor_si128(b0, k);
+		b1 = _mm_xor_si128(b1, k);
+		b2 = _mm_xor_si128(b2, k);
+		b3 = _mm_xor_si128(b3, k);
+		b4 = _mm_xor_si128(b4, k);
+		b5 = _mm_xor_si128(b5, k);
+		b6 = _mm_xor_si128(b6, k);
+		b7 = _mm_xor_si128(b7, k);
+		for (int r = 1; r < nr; r++)
+		{
+			k = _mm_loadu_si128(rk + r);
+			b0 = decrypt ? _mm_aesdec_si128(b0, k) : _mm_aesenc_si128(b0, k);
+			b1 = decrypt ? _mm_aesdec_si128(b1, k) : _mm_aesenc_si128(b1, k);
+			b2 = decrypt ? _mm_aesdec_si128(b2, k) : _mm_aesenc_si128(b2, k);
+			b3 = decrypt ? _mm_aesdec_si128(b3, k) : _mm_aesenc_si128(b3, k);
+			b4 = decrypt ? _mm_aesdec_si128(b4, k) : _mm_aesenc_si128(b4, k);
+			b5 = decrypt ? _mm_aesdec_si128(b5, k) : _mm_aesenc_si128(b5, k);
+			b6 = decrypt ? _mm_aesdec_si128(b6, k) : _mm_aesenc_si128(b6, k);
+			b7 = decrypt ? _mm_aesdec_si128(b7, k) : _mm_aesenc_si128(b7, k);
+		}
+		k = _mm_loadu_si128(rk + nr);
+		b0 = decrypt ? _mm_aesdeclast_si128(b0, k) : _mm_aesenclast_si128(b0, k);
+		b1 = decrypt ? _mm_aesdeclast_si128(b1, k) : _mm_aesenclast_si128(b1, k);
+		b2 = decrypt ? _mm_aesdeclast_si128(b2, k) : _mm_aesenclast_si128(b2, k);
+		b3 = decrypt ? _mm_aesdeclast_si128(b3, k) : _mm_aesenclast_si128(b3, k);
+		b4 = decrypt ? _mm_aesdeclast_si128(b4, k) : _mm_aesenclast_si128(b4, k);
+		b5 = decrypt ? _mm_aesdeclast_si128(b5, k) : _mm_aesenclast_si128(b5, k);
+		b6 = decrypt ? _mm_aesdeclast_si128(b6, k) : _mm_aesenclast_si128(b6, k);
+		b7 = decrypt ? _mm_aesdeclast_si128(b7, k) : _mm_aesenclast_si128(b7, k);
+		if (ctr)
+		{
+			b0 = _mm_xor_si128(b0, _mm_loadu_si128((const __m128i*)in));
+			b1 = _mm_xor_si128(b1, _mm_loadu_si128((const __m128i*)(in + 16)));
+			b2 = _mm_xor_si128(b2, _mm_loadu_si128((const __m128i*)(in + 32)));
+			b3 = _mm_xor_si128(b3, _mm_loadu_si128((const __m128i*)(in + 48)));
+			b4 = _mm_xor_si128(b4, _mm_loadu_si128((const __m128i*)(in + 64)));
+			b5 = _mm_xor_si128(b5, _mm_loadu_si128((const __m128i*)(in + 80)));
+			b6 = _mm_xor_si128(b6, _mm_loadu_si128((const __m128i*)(in + 96)));
+			b7 = _mm_xor_si128(b7, _mm_loadu_si128((const __m128i*)(in + 112)));
+		}
+		_mm_storeu_si128((__m128i*)out, b0);
+		_mm_storeu_si128((__m128i*)(out + 16), b1);
+		_mm_storeu_si128((__m128i*)(out + 32), b2);
+		_mm_storeu_si128((__m128i*)(out + 48), b3);
+		_mm_storeu_si128((__m128i*)(out + 64), b4);
+		_mm_storeu_si128((__m128i*)(out + 80), b5);
+		_mm_storeu_si128((__m128i*)(out + 96), b6);
+		_mm_storeu_si128((__m128i*)(out + 112), b7);
+	}
+
+	for (; blocks > 0; blocks--, in += 16, out += 16)
+	{
+		b0 = ctr ? ic_aesni_next_counter(c, reverse) : _mm_loadu_si128((const __m128i*)in);
+		b0 = _mm_xor_si128(b0, _mm_loadu_si128(rk));
+		for (int r = 1; r < nr; r++)
+		{
+			b0 = decrypt ? _mm_aesdec_si128(b0, _mm_loadu_si128(rk + r)) : _mm_aesenc_si128(b0, _mm_loadu_si128(rk + r));
+		}
+		b0 = decrypt ? _mm_aesdeclast_si128(b0, _mm_loadu_si128(rk + nr)) : _mm_aesenclast_si128(b0, _mm_loadu_si128(rk + nr));
+		if (ctr)
+		{
+			b0 = _mm_xor_si128(b0, _mm_loadu_si128((const __m128i*)in));
+		}
+		_mm_storeu_si128((__m128i*)out, b0);
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#pragma clang attribute push(__attribute__((target("vaes,avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("vaes,avx512f")
+#endif
+
+// The counter blocks of one register from the four counters in cz, which then move on by four.
+// Without AVX512BW the bytes are reversed a 256-bit half at a time.
+static __m512i ic_vaes_next_counters(__m512i* cz, bool reverse)
+{
+	__m512i v = *cz;
+	*cz = _mm512_add_epi64(v, _mm512_set_epi64(0, 4, 0, 4, 0, 4, 0, 4));
+	if (reverse)
+	{
+		const __m256i order = _mm256_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+		__m256i lo = _mm256_shuffle_epi8(_mm512_castsi512_si256(v), order);
+		__m256i hi = _mm256_shuffle_epi8(_mm512_extracti64x4_epi64(v, 1), order);
+		v = _mm512_inserti64x4(_mm512_castsi256_si512(lo), hi, 1);
+	}
+	return v;
+}
+
+// groups of sixteen blocks, four per register, with the round keys broadcast once; ctr as for
+// ic_aesni_blocks
+template <bool decrypt, bool ctr>
+static void ic_vaes_blocks16(const unsigned char* in, unsigned char* out, unsigned long groups, const symmetric_key* skey, __m128i* c, bool reverse)
+{
+	const __m128i* rk = (const __m128i*)(decrypt ? skey->rijndael.dK : skey->rijndael.eK);
+	int nr = skey->rijndael.Nr;
+	__m512i k[15];
+	for (int r = 0; r <= nr; r++)
+	{
+		k[r] = _mm512_broadcast_i32x4(_mm_loadu_si128(rk + r));
+	}
+
+	// The counters after *c, four per register
+	__m512i cz = _mm512_setzero_si512();
+	if (ctr)
+	{
+		cz = _mm512_add_epi64(_mm512_broadcast_i32x4(*c), _mm512_set_epi64(0, 4, 0, 3, 0, 2, 0, 1));
+		*c = _mm_add_epi64(*c, _mm_set_epi64x(0, (long long)(groups * 16)));
+	}
+
+	__m512i b0, b1, b2, b3;
+	for (; groups > 0; groups--, in += 256, out += 256)
+	{
+		if (ctr)
+		{
+			b0 = ic_vaes_next_counters(&cz, reverse);
+			b1 = ic_vaes_next_counters(&cz, reverse);
+			b2 = ic_vaes_next_counters(&cz, reverse);
+			b3 = ic_vaes_next_counters(&cz, reverse);
+		}
+		else
+		{
+			b0 = _mm512_loadu_si512((const void*)in);
+			b1 = _mm512_loadu_si512((const void*)(in + 64));
+			b2 = _mm512_loadu_si512((const void*)(in + 128));
+			b3 = _mm512_loadu_si512((const void*)(in + 192));
+		}
+		b0 = _mm512_xor_si512(b0, k[0]);
+		b1 = _mm512_xor_si512(b1, k[0]);
+		b2 = _mm512_xor_si512(b2, k[0]);
+		b3 = _mm512_xor_si512(b3, k[0]);
+		for (int r = 1; r < nr; r++)
+		{
+			b0 = decrypt ? _mm512_aesdec_epi128(b0, k[r]) : _mm512_aesenc_epi128(b0, k[r]);
+			b1 = decrypt ? _mm512_aesdec_epi128(b1, k[r]) : _mm512_aesenc_epi128(b1, k[r]);
+			b2 = decrypt ? _mm512_aesdec_epi128(b2, k[r]) : _mm512_aesenc_epi128(b2, k[r]);
+			b3 = decrypt ? _mm512_aesdec_epi128(b3, k[r]) : _mm512_aesenc_epi128(b3, k[r]);
+		}
+		b0 = decrypt ? _mm512_aesdeclast_epi128(b0, k[nr]) : _mm512_aesenclast_epi128(b0, k[nr]);
+		b1 = decrypt ? _mm512_aesdeclast_epi128(b1, k[nr]) : _mm512_aesenclast_epi128(b1, k[nr]);
+		b2 = decrypt ? _mm512_aesdeclast_epi128(b2, k[nr]) : _mm512_aesenclast_epi128(b2, k[nr]);
+		b3 = decrypt ? _mm512_aesdeclast_epi128(b3, k[nr]) : _mm512_aesenclast_epi128(b3, k[nr]);
+		if (ctr)
+		{
+			b0 = _mm512_xor_si512(b0, _mm512_loadu_si512((const void*)in));
+			b1 = _mm512_xor_si512(b1, _mm512_loadu_si512((const void*)(in + 64)));
+			b2 = _mm512_xor_si512(b2, _mm512_loadu_si512((const void*)(in + 128)));
+			b3 = _mm512_xor_si512(b3, _mm512_loadu_si512((const void*)(in + 192)));
+		}
+		_mm512_storeu_si512((void*)out, b0);
+		_mm512_storeu_si512((void*)(out + 64), b1);
+		_mm512_storeu_si512((void*)(out + 128), b2);
+		_mm512_storeu_si512((void*)(out + 192), b3);
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+template <bool decrypt, bool ctr>
+static void ic_aes_blocks(const unsigned char* in, unsigned char* out, unsigned long blocks, const symmetric_key* skey, __m128i* c, bool reverse)
+{
+	if (blocks >= 16 && (ic_cpu_features() & IC_CPU_VAES))
+	{
+		ic_vaes_blocks16<decrypt, ctr>(in, out, blocks / 16, skey, c, reverse);
+		in += (blocks & ~15UL) * 16;
+		out += (blocks & ~15UL) * 16;
+		blocks &= 15;
+	}
+	ic_aesni_blocks<decrypt, ctr>(in, out, blocks, skey, c, reverse);
+}
+
+static int ic_aesni_ecb_encrypt(const unsigned char* pt, unsigned char* ct, const symmetric_key* skey)
+{
+	LTC_ARGCHK(pt != NULL);
+	LTC_ARGCHK(ct != NULL);
+	LTC_ARGCHK(skey != NULL);
+	ic_aesni_blocks<false, false>(pt, ct, 1, skey, NULL, false);
+	return CRYPT_OK;
+}
+
+static int ic_aesni_ecb_decrypt(const unsigned char* ct, unsigned char* pt, const symmetric_key* skey)
+{
+	LTC_ARGCHK(pt != NULL);
+	LTC_ARGCHK(ct != NULL);
+	LTC_ARGCHK(skey != NULL);
+	ic_aesni_blocks<true, false>(ct, pt, 1, skey, NULL, false);
+	return CRYPT_OK;
+}
+
+static int ic_aesni_accel_ecb_encrypt(const unsigned char* pt, unsigned char* ct, unsigned long blocks, symmetric_key* skey)
+{
+	LTC_ARGCHK(pt != NULL);
+	LTC_ARGCHK(ct != NULL);
+	LTC_ARGCHK(skey != NULL);
+	ic_aes_blocks<false, false>(pt, ct, blocks, skey, NULL, false);
+	return CRYPT_OK;
+}
+
+static int ic_aesni_accel_ecb_decrypt(const unsigned char* ct, unsigned char* pt, unsigned long blocks, symmetric_key* skey)
+{
+	LTC_ARGCHK(pt != NULL);
+	LTC_ARGCHK(ct != NULL);
+	LTC_ARGCHK(skey != NULL);
+	ic_aes_blocks<true, false>(ct, pt, blocks, skey, NULL, false);
+	return CRYPT_OK;
+}
+
+// As ctr_encrypt, IV holds the counter of the last block used and is incremented before each block.
+// ctr_encrypt only comes here for counters that span the whole block.
+static int ic_aesni_accel_ctr_encrypt(const unsigned char* pt, unsigned char* ct, unsigned long blocks, unsigned char* IV, int mode, symmetric_key* skey)
+{
+	LTC_ARGCHK(pt != NULL);
+	LTC_ARGCHK(ct != NULL);
+	LTC_ARGCHK(IV != NULL);
+	LTC_ARGCHK(skey != NULL);
+
+	bool reverse = mode != CTR_COUNTER_LITTLE_ENDIAN;
+	ulong64 hi, lo;
+	if (reverse)
+	{
+		LOAD64H(hi, IV);
+		LOAD64H(lo, IV + 8);
+	}
+	else
+	{
+		LOAD64L(lo, IV);
+		LOAD64L(hi, IV + 8);
+	}
+
+	// The kernels add to the low half only, so run them up to where it wraps
+	while (blocks > 0)
+	{
+		ulong64 room = ~(ulong64)0 - lo;
+		if (room == 0)
+		{
+			// lo wraps on the next block; with hi carried already the add comes to hi:0
+			hi++;
+			room = ~(ulong64)0;
+		}
+		unsigned long n = (ulong64)blocks < room ? blocks : (unsigned long)room;
+		__m128i c = _mm_set_epi64x((long long)hi, (long long)lo);
+		ic_aes_blocks<false, true>(pt, ct, n, skey, &c, reverse);
+		lo += n;
+		pt += n * 16;
+		ct += n * 16;
+		blocks -= n;
+	}
+
+	if (reverse)
+	{
+		STORE64H(hi, IV);
+		STORE64H(lo, IV + 8);
+	}
+	else
+	{
+		STORE64L(lo, IV);
+		STORE64L(hi, IV + 8);
+	}
+	return CRYPT_OK;
+}
+
+// The test of aes.c (the FIPS-197 vectors and 1000 rounds there and back), then the accelerated
+// ECB and CTR over enough blocks to reach every kernel, against one block at a time
+static int ic_aesni_test(void)
+{
+#ifndef LTC_TEST
+	return CRYPT_NOP;
+#else
+	static const struct
+	{
+		int keylen;
+		unsigned char key[32], pt[16], ct[16];
+	} tests[] =
+	{
+		{
+			16,
+			{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f },
+			{ 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff },
+			{ 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a }
+		},
+		{
+			24,
+			{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+			  0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17 },
+			{ 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff },
+			{ 0xdd, 0xa9, 0x7c, 0xa4, 0x86, 0x4c, 0xdf, 0xe0, 0x6e, 0xaf, 0x70, 0xa0, 0xec, 0x0d, 0x71, 0x91 }
+		},
+		{
+			32,
+			{ 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+			  0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f },
+			{ 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff },
+			{ 0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89 }
+		}
+	};
+
+	symmetric_key key;
+	unsigned char tmp[2][16];
+	unsigned char buf[3][45 * 16];
+	int err;
+
+	for (int i = 0; i < (int)(sizeof(tests) / sizeof(tests[0])); i++)
+	{
+		zeromem(&key, sizeof(key));
+		if ((err = ic_aesni_setup(tests[i].key, tests[i].keylen, 0, &key)) != CRYPT_OK)
+		{
+			return err;
+		}
+
+		ic_aesni_ecb_encrypt(tests[i].pt, tmp[0], &key);
+		ic_aesni_ecb_decrypt(tmp[0], tmp[1], &key);
+		if (memcmp(tmp[0], tests[i].ct, 16) != 0 || memcmp(tmp[1], tests[i].pt, 16) != 0)
+		{
+			return CRYPT_FAIL_TESTVECTOR;
+		}
+
+		memset(tmp[0], 0, 16);
+		for (int y = 0; y < 1000; y++)
+		{
+			ic_aesni_ecb_encrypt(tmp[0], tmp[0], &key);
+		}
+		for (int y = 0; y < 1000; y++)
+		{
+			ic_aesni_ecb_decrypt(tmp[0], tmp[0], &key);
+		}
+		for (int y = 0; y < 16; y++)
+		{
+			if (tmp[0][y] != 0)
+			{
+				return CRYPT_FAIL_TESTVECTOR;
+			}
+		}
+
+		// 45 blocks: sixteen, eight, four and one per kernel call
+		for (int y = 0; y < (int)sizeof(buf[0]); y++)
+		{
+			buf[0][y] = (unsigned char)(y * 7 + i);
+		}
+		ic_aesni_accel_ecb_encrypt(buf[0], buf[1], 45, &key);
+		for (int b = 0; b < 45; b++)
+		{
+			ic_aesni_ecb_encrypt(buf[0] + 16 * b, tmp[0], &key);
+			if (memcmp(tmp[0], buf[1] + 16 * b, 16) != 0)
+			{
+				return CRYPT_FAIL_TESTVECTOR;
+			}
+		}
+		ic_aesni_accel_ecb_decrypt(buf[1], buf[2], 45, &key);
+		if (memcmp(buf[0], buf[2], sizeof(buf[0])) != 0)
+		{
+			return CRYPT_FAIL_TESTVECTOR;
+		}
+
+		// CTR in both byte orders, from a counter whose low half wraps part way
+		for (int le = 0; le < 2; le++)
+		{
+			unsigned char iv[16], ctr[16];
+			memset(iv, 0, 16);
+			memset(iv + (le ? 0 : 8), 0xff, 8);
+			iv[le ? 0 : 15] = 0xf0;
+			memcpy(ctr, iv, 16);
+			ic_aesni_accel_ctr_encrypt(buf[0], buf[1], 45, iv, le ? CTR_COUNTER_LITTLE_ENDIAN : CTR_COUNTER_BIG_ENDIAN, &key);
+			for (int b = 0; b < 45; b++)
+			{
+				for (int x = 0; x < 16; x++)
+				{
+					if (++ctr[le ? x : 15 - x] != 0)
+					{
+						break;
+					}
+				}
+				ic_aesni_ecb_encrypt(ctr, tmp[0], &key);
+				for (int y = 0; y < 16; y++)
+				{
+					if ((tmp[0][y] ^ buf[0][16 * b + y]) != buf[1][16 * b + y])
+					{
+						return CRYPT_FAIL_TESTVECTOR;
+					}
+				}
+			}
+			if (memcmp(ctr, iv, 16) != 0)
+			{
+				return CRYPT_FAIL_TESTVECTOR;
+			}
+		}
+	}
+	return CRYPT_OK;
+#endif
+}
+
+const struct ltc_cipher_descriptor ic_aesni_desc =
+{
+	"aes",
+	6,
+	16, 32, 16, 10,
+	ic_aesni_setup, ic_aesni_ecb_encrypt, ic_aesni_ecb_decrypt, ic_aesni_test, rijndael_done, rijndael_keysize,
+	ic_aesni_accel_ecb_encrypt, ic_aesni_accel_ecb_decrypt, NULL, NULL, ic_aesni_accel_ctr_encrypt, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
+};
+#endif
+
+const struct ltc_cipher_descriptor* ic_aes_desc(void)
+{
+#ifdef IC_CPU_X86
+	if (ic_cpu_features() & IC_CPU_AESNI)
+	{
+		return &ic_aesni_desc;
+	}
+#endif
+	return &aes_desc;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "IC_CPU.h"
+#include <tomcrypt.h>
+
+#ifdef IC_CPU_X86
+/*
+* AES on AES-NI, named "aes" like aes_desc and tested with the same vectors. The round keys are kept
+* in the rijndael_key of symmetric_key in AES-NI order, not as T-table words, so a key scheduled by
+* one descriptor can not be used with the other.
+* accel_ecb_encrypt, accel_ecb_decrypt and accel_ctr_encrypt run eight blocks at a time, and sixteen with VAES.
+* Only usable when ic_cpu_features reports IC_CPU_AESNI.
+*/
+extern const struct ltc_cipher_descriptor ic_aesni_desc;
+#endif
+
+/*
+* The AES descriptor to register: ic_aesni_desc on CPUs with AES-NI, otherwise the T-table aes_desc
+*/
+const struct ltc_cipher_descriptor* ic_aes_desc(void);
@@ -0,0 +1,101 @@
+#include "IC_CPU.h"
+
+#ifdef IC_CPU_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef IC_CPU_X86
+static void ic_cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+	int r[4];
+	__cpuidex(r, (int)leaf, (int)subleaf);
+	for (int i = 0; i < 4; i++)
+	{
+		regs[i] = (unsigned int)r[i];
+	}
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Register state the OS saves on context switch (XCR0)
+static unsigned long long ic_xgetbv0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int lo, hi;
+	__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+
+static unsigned int ic_detect_features()
+{
+	unsigned int regs[4];
+	unsigned int features = 0;
+	unsigned long long xcr0 = 0;
+
+	ic_cpuid(0, 0, regs);
+	unsigned int max_leaf = regs[0];
+	if (max_leaf < 1)
+	{
+		return 0;
+	}
+	ic_cpuid(1, 0, regs);
+	if (regs[2] & (1u << 25))
+	{
+		features |= IC_CPU_AESNI;
+	}
+	if (regs[2] & (1u << 1))
+	{
+		features |= IC_CPU_PCLMUL;
+	}
+	if (regs[2] & (1u << 27)) // OSXSAVE
+	{
+		xcr0 = ic_xgetbv0();
+	}
+	if (max_leaf < 7)
+	{
+		return features;
+	}
+	ic_cpuid(7, 0, regs);
+	// AVX2 needs the OS to save XMM and YMM
+	if ((regs[1] & (1u << 5)) && (xcr0 & 0x6) == 0x6)
+	{
+		features |= IC_CPU_AVX2;
+	}
+	// AVX-512F also needs the opmask and both ZMM halves saved
+	if ((regs[1] & (1u << 16)) && (xcr0 & 0xE6) == 0xE6)
+	{
+		features |= IC_CPU_AVX512F;
+		if ((regs[2] & (1u << 9)) && (features & IC_CPU_AESNI))
+		{
+			features |= IC_CPU_VAES;
+		}
+	}
+	return features;
+}
+#endif
+
+unsigned int ic_cpu_features(void)
+{
+#ifdef IC_CPU_X86
+	// Racing first calls detect the same value, so a plain static is enough
+	static volatile int detected = 0;
+	static volatile unsigned int features = 0;
+	if (!detected)
+	{
+		features = ic_detect_features();
+		detected = 1;
+	}
+	return features;
+#else
+	return 0;
+#endif
+}
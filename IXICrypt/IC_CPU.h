@@ -0,0 +1,27 @@
+#pragma once
+
+// Instruction set extensions the CPU has and the OS saves the registers of.
+// Detected once; usable from both the C++ code and libtomcrypt.
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define IC_CPU_X86
+#endif
+
+#define IC_CPU_AVX2		(1u << 0)
+#define IC_CPU_AVX512F	(1u << 1)
+#define IC_CPU_AESNI	(1u << 2)
+// VAES on 512-bit registers, so only reported together with IC_CPU_AVX512F
+#define IC_CPU_VAES		(1u << 3)
+#define IC_CPU_PCLMUL	(1u << 4)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+	/*
+	* Returns a mask of IC_CPU_* flags, 0 on non-x86 builds
+	*/
+	unsigned int ic_cpu_features(void);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,240 @@
+#include "IC_ChaCha.h"
+#include <string.h>
+
+#ifdef IC_CPU_X86
+#include <immintrin.h>
+
+// As in IC_SHA512.cpp, each kernel is compiled for its own instruction set and only called once
+// ic_cpu_features reports it. SSE2 is part of x86-64, so that one needs no check.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+static void ic_chacha_write_sse2(const __m128i* x, const unsigned char* in, unsigned char* out)
+{
+	for (int b = 0; b < 4; b++)
+	{
+		for (int w = 0; w < 4; w++)
+		{
+			__m128i d = _mm_loadu_si128((const __m128i*)(in + b * 64 + w * 16));
+			_mm_storeu_si128((__m128i*)(out + b * 64 + w * 16), _mm_xor_si128(d, x[w * 4 + b]));
+		}
+	}
+}
+
+#define IC_CHACHA_LANES		4
+#define IC_CHACHA_BLOCKS	ic_chacha_blocks_sse2
+#define IC_CHACHA_WRITE		ic_chacha_write_sse2
+#define V					__m128i
+#define V_SET1(x)			_mm_set1_epi32((int)(x))
+#define V_LANE_INDEX		_mm_set_epi32(3, 2, 1, 0)
+#define V_ADD(x, y)			_mm_add_epi32(x, y)
+#define V_XOR(x, y)			_mm_xor_si128(x, y)
+#define V_ROL(x, n)			_mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - (n)))
+#define V_UNPACKLO32(x, y)	_mm_unpacklo_epi32(x, y)
+#define V_UNPACKHI32(x, y)	_mm_unpackhi_epi32(x, y)
+#define V_UNPACKLO64(x, y)	_mm_unpacklo_epi64(x, y)
+#define V_UNPACKHI64(x, y)	_mm_unpackhi_epi64(x, y)
+#include "IC_ChaCha_lanes.inl"
+#undef IC_CHACHA_LANES
+#undef IC_CHACHA_BLOCKS
+#undef IC_CHACHA_WRITE
+#undef V
+#undef V_SET1
+#undef V_LANE_INDEX
+#undef V_ADD
+#undef V_XOR
+#undef V_ROL
+#undef V_UNPACKLO32
+#undef V_UNPACKHI32
+#undef V_UNPACKLO64
+#undef V_UNPACKHI64
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+// Rotations by whole bytes are a single shuffle
+static __m256i ic_chacha_rol_avx2(__m256i x, int n)
+{
+	if (n == 16)
+	{
+		return _mm256_shuffle_epi8(x, _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+			13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+	}
+	if (n == 8)
+	{
+		return _mm256_shuffle_epi8(x, _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+			14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3));
+	}
+	return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n));
+}
+
+// The low 128-bit lanes hold blocks 0-3 and the high ones blocks 4-7
+static void ic_chacha_write_avx2(const __m256i* x, const unsigned char* in, unsigned char* out)
+{
+	for (int b = 0; b < 4; b++)
+	{
+		for (int h = 0; h < 2; h++)
+		{
+			__m256i lo = _mm256_permute2x128_si256(x[h * 8 + b], x[h * 8 + 4 + b], 0x20);
+			__m256i hi = _mm256_permute2x128_si256(x[h * 8 + b], x[h * 8 + 4 + b], 0x31);
+			const unsigned char* src = in + b * 64 + h * 32;
+			unsigned char* dst = out + b * 64 + h * 32;
+			_mm256_storeu_si256((__m256i*)dst, _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)src), lo));
+			_mm256_storeu_si256((__m256i*)(dst + 256), _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(src + 256)), hi));
+		}
+	}
+}
+
+#define IC_CHACHA_LANES		8
+#define IC_CHACHA_BLOCKS	ic_chacha_blocks_avx2
+#define IC_CHACHA_WRITE		ic_chacha_write_avx2
+#define V					__m256i
+#define V_SET1(x)			_mm256_set1_epi32((int)(x))
+#define V_LANE_INDEX		_mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0)
+#define V_ADD(x, y)			_mm256_add_epi32(x, y)
+#define V_XOR(x, y)			_mm256_xor_si256(x, y)
+#define V_ROL(x, n)			ic_chacha_rol_avx2(x, n)
+#define V_UNPACKLO32(x, y)	_mm256_unpacklo_epi32(x, y)
+#define V_UNPACKHI32(x, y)	_mm256_unpackhi_epi32(x, y)
+#define V_UNPACKLO64(x, y)	_mm256_unpacklo_epi64(x, y)
+#define V_UNPACKHI64(x, y)	_mm256_unpackhi_epi64(x, y)
+#include "IC_ChaCha_lanes.inl"
+#undef IC_CHACHA_LANES
+#undef IC_CHACHA_BLOCKS
+#undef IC_CHACHA_WRITE
+#undef V
+#undef V_SET1
+#undef V_LANE_INDEX
+#undef V_ADD
+#undef V_XOR
+#undef V_ROL
+#undef V_UNPACKLO32
+#undef V_UNPACKHI32
+#undef V_UNPACKLO64
+#undef V_UNPACKHI64
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+// 128-bit lane l holds block 4 * l + b of each group of four words; shuffling the lanes of the
+// four groups gives whole blocks
+static void ic_chacha_write_avx512(const __m512i* x, const unsigned char* in, unsigned char* out)
+{
+	for (int b = 0; b < 4; b++)
+	{
+		__m512i t0 = _mm512_shuffle_i32x4(x[b], x[4 + b], 0x44);
+		__m512i t1 = _mm512_shuffle_i32x4(x[8 + b], x[12 + b], 0x44);
+		__m512i t2 = _mm512_shuffle_i32x4(x[b], x[4 + b], 0xEE);
+		__m512i t3 = _mm512_shuffle_i32x4(x[8 + b], x[12 + b], 0xEE);
+		__m512i k[4] =
+		{
+			_mm512_shuffle_i32x4(t0, t1, 0x88), _mm512_shuffle_i32x4(t0, t1, 0xDD),
+			_mm512_shuffle_i32x4(t2, t3, 0x88), _mm512_shuffle_i32x4(t2, t3, 0xDD)
+		};
+		for (int l = 0; l < 4; l++)
+		{
+			size_t offset = (l * 4 + b) * 64;
+			_mm512_storeu_si512((void*)(out + offset), _mm512_xor_si512(_mm512_loadu_si512((const void*)(in + offset)), k[l]));
+		}
+	}
+}
+
+#define IC_CHACHA_LANES		16
+#define IC_CHACHA_BLOCKS	ic_chacha_blocks_avx512
+#define IC_CHACHA_WRITE		ic_chacha_write_avx512
+#define V					__m512i
+#define V_SET1(x)			_mm512_set1_epi32((int)(x))
+#define V_LANE_INDEX		_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define V_ADD(x, y)			_mm512_add_epi32(x, y)
+#define V_XOR(x, y)			_mm512_xor_si512(x, y)
+#define V_ROL(x, n)			_mm512_rol_epi32(x, n)
+#define V_UNPACKLO32(x, y)	_mm512_unpacklo_epi32(x, y)
+#define V_UNPACKHI32(x, y)	_mm512_unpackhi_epi32(x, y)
+#define V_UNPACKLO64(x, y)	_mm512_unpacklo_epi64(x, y)
+#define V_UNPACKHI64(x, y)	_mm512_unpackhi_epi64(x, y)
+#include "IC_ChaCha_lanes.inl"
+#undef IC_CHACHA_LANES
+#undef IC_CHACHA_BLOCKS
+#undef IC_CHACHA_WRITE
+#undef V
+#undef V_SET1
+#undef V_LANE_INDEX
+#undef V_ADD
+#undef V_XOR
+#undef V_ROL
+#undef V_UNPACKLO32
+#undef V_UNPACKHI32
+#undef V_UNPACKLO64
+#undef V_UNPACKHI64
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+static void ic_chacha_crypt(const ulong32* input, int rounds, const unsigned char* in, unsigned char* out, unsigned long blocks)
+{
+	ulong32 counter = input[12];
+	unsigned long done = 0;
+
+	unsigned int features = ic_cpu_features();
+	if (features & IC_CPU_AVX512F)
+	{
+		ic_chacha_blocks_avx512(input, counter, rounds, in, out, blocks / 16);
+		done = blocks & ~15ul;
+	}
+	if (features & IC_CPU_AVX2)
+	{
+		ic_chacha_blocks_avx2(input, counter + (ulong32)done, rounds, in + done * 64, out + done * 64, (blocks - done) / 8);
+		done = blocks & ~7ul;
+	}
+	ic_chacha_blocks_sse2(input, counter + (ulong32)done, rounds, in + done * 64, out + done * 64, (blocks - done) / 4);
+	done = blocks & ~3ul;
+
+	// Up to three blocks left, through a buffer of four
+	if (done < blocks)
+	{
+		unsigned char buf[256];
+		unsigned long len = (blocks - done) * 64;
+		memset(buf, 0, sizeof(buf));
+		ic_chacha_blocks_sse2(input, counter + (ulong32)done, rounds, buf, buf, 1);
+		for (unsigned long i = 0; i < len; i++)
+		{
+			out[done * 64 + i] = in[done * 64 + i] ^ buf[i];
+		}
+		zeromem(buf, sizeof(buf));
+	}
+}
+
+static const ltc_chacha_accel_descriptor ic_chacha_simd_desc =
+{
+	"simd",
+	ic_chacha_crypt
+};
+#endif
+
+const ltc_chacha_accel_descriptor* ic_chacha_accel(void)
+{
+#ifdef IC_CPU_X86
+	return &ic_chacha_simd_desc;
+#else
+	return 0;
+#endif
+}
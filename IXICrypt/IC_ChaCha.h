@@ -0,0 +1,11 @@
+#pragma once
+
+#include "IC_CPU.h"
+#include <tomcrypt.h>
+
+/*
+* Multi-block ChaCha for libtomcrypt, to set as ltc_chacha_accel; 0 on non-x86 builds. Computes
+* sixteen blocks at a time with AVX-512F, eight with AVX2 and four with SSE2, whichever the CPU has,
+* giving the same key stream as chacha_crypt.
+*/
+const ltc_chacha_accel_descriptor* ic_chacha_accel(void);
@@ -0,0 +1,64 @@
+// ChaCha of consecutive blocks, one block per vector lane.
+// Included by IC_ChaCha.cpp once per instruction set, with these defined:
+//   IC_CHACHA_LANES	blocks computed together
+//   IC_CHACHA_BLOCKS	name of the function to define
+//   IC_CHACHA_WRITE	function XORing the words, transposed within 128-bit lanes, into the text
+//   V					vector of IC_CHACHA_LANES 32-bit words
+//   V_SET1, V_LANE_INDEX, V_ADD, V_XOR, V_ROL, V_UNPACKLO32, V_UNPACKHI32, V_UNPACKLO64, V_UNPACKHI64
+
+#define IC_CHACHA_QUARTERROUND(a, b, c, d) \
+	x[a] = V_ADD(x[a], x[b]); x[d] = V_ROL(V_XOR(x[d], x[a]), 16); \
+	x[c] = V_ADD(x[c], x[d]); x[b] = V_ROL(V_XOR(x[b], x[c]), 12); \
+	x[a] = V_ADD(x[a], x[b]); x[d] = V_ROL(V_XOR(x[d], x[a]), 8); \
+	x[c] = V_ADD(x[c], x[d]); x[b] = V_ROL(V_XOR(x[b], x[c]), 7);
+
+// Words a..d of each block in a 128-bit lane become the four words of a single block
+#define IC_CHACHA_TRANSPOSE(a, b, c, d) \
+	{ \
+		V t0 = V_UNPACKLO32(x[a], x[b]), t1 = V_UNPACKLO32(x[c], x[d]); \
+		V t2 = V_UNPACKHI32(x[a], x[b]), t3 = V_UNPACKHI32(x[c], x[d]); \
+		x[a] = V_UNPACKLO64(t0, t1); \
+		x[b] = V_UNPACKHI64(t0, t1); \
+		x[c] = V_UNPACKLO64(t2, t3); \
+		x[d] = V_UNPACKHI64(t2, t3); \
+	}
+
+// XORs groups * IC_CHACHA_LANES blocks of key stream into in, the first block with counter word
+// counter and the rest of the state from input
+static void IC_CHACHA_BLOCKS(const ulong32* input, ulong32 counter, int rounds, const unsigned char* in, unsigned char* out, unsigned long groups)
+{
+	for (; groups > 0; groups--, counter += IC_CHACHA_LANES, in += 64 * IC_CHACHA_LANES, out += 64 * IC_CHACHA_LANES)
+	{
+		V x[16];
+		for (int i = 0; i < 16; i++)
+		{
+			x[i] = V_SET1(input[i]);
+		}
+		x[12] = V_ADD(V_SET1(counter), V_LANE_INDEX);
+
+		for (int i = rounds; i > 0; i -= 2)
+		{
+			IC_CHACHA_QUARTERROUND(0, 4, 8, 12)
+			IC_CHACHA_QUARTERROUND(1, 5, 9, 13)
+			IC_CHACHA_QUARTERROUND(2, 6, 10, 14)
+			IC_CHACHA_QUARTERROUND(3, 7, 11, 15)
+			IC_CHACHA_QUARTERROUND(0, 5, 10, 15)
+			IC_CHACHA_QUARTERROUND(1, 6, 11, 12)
+			IC_CHACHA_QUARTERROUND(2, 7, 8, 13)
+			IC_CHACHA_QUARTERROUND(3, 4, 9, 14)
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			x[i] = V_ADD(x[i], i == 12 ? V_ADD(V_SET1(counter), V_LANE_INDEX) : V_SET1(input[i]));
+		}
+		IC_CHACHA_TRANSPOSE(0, 1, 2, 3)
+		IC_CHACHA_TRANSPOSE(4, 5, 6, 7)
+		IC_CHACHA_TRANSPOSE(8, 9, 10, 11)
+		IC_CHACHA_TRANSPOSE(12, 13, 14, 15)
+		IC_CHACHA_WRITE(x, in, out);
+	}
+}
+
+#undef IC_CHACHA_QUARTERROUND
+#undef IC_CHACHA_TRANSPOSE
@@ -0,0 +1,192 @@
+#include "IC_GCM.h"
+#include "IC_AES.h"
+
+#ifdef IC_CPU_X86
+#include <immintrin.h>
+
+// As in IC_AES.cpp, compiled for the instructions used and only reached through ic_gcm_accel,
+// which checks for PCLMULQDQ; the AES-NI pass only runs for keys scheduled by ic_aesni_desc.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("pclmul,aes,ssse3"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("pclmul,aes,ssse3")
+#endif
+
+// GCM numbers are bit-reflected; with the bytes reversed too, x^i is bit 127 - i of the register
+static __m128i ic_gcm_reverse(__m128i x)
+{
+	return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+// Adds the 256-bit carry-less product of a and b to hi:lo
+static void ic_gcm_clmul(__m128i a, __m128i b, __m128i* lo, __m128i* hi)
+{
+	__m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+	*lo = _mm_xor_si128(*lo, _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x00), _mm_slli_si128(mid, 8)));
+	*hi = _mm_xor_si128(*hi, _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x11), _mm_srli_si128(mid, 8)));
+}
+
+// hi:lo reduced modulo the GCM polynomial. The product of two reflected numbers comes out one bit
+// short, so it is shifted left by one first; both steps are linear, so a sum of products can be
+// reduced once. This is the reduction of Intel's carry-less multiplication white paper.
+static __m128i ic_gcm_reduce(__m128i lo, __m128i hi)
+{
+	__m128i lo_carry = _mm_srli_epi32(lo, 31);
+	__m128i hi_carry = _mm_srli_epi32(hi, 31);
+	lo = _mm_or_si128(_mm_slli_epi32(lo, 1), _mm_slli_si128(lo_carry, 4));
+	hi = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(hi, 1), _mm_slli_si128(hi_carry, 4)), _mm_srli_si128(lo_carry, 12));
+
+	__m128i t = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)), _mm_slli_epi32(lo, 25));
+	lo = _mm_xor_si128(lo, _mm_slli_si128(t, 12));
+	__m128i u = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)), _mm_srli_epi32(lo, 7));
+	u = _mm_xor_si128(u, _mm_srli_si128(t, 4));
+	return _mm_xor_si128(hi, _mm_xor_si128(lo, u));
+}
+
+static __m128i ic_gcm_mul(__m128i a, __m128i b)
+{
+	__m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+	ic_gcm_clmul(a, b, &lo, &hi);
+	return ic_gcm_reduce(lo, hi);
+}
+
+static int ic_gcm_init(gcm_state* gcm)
+{
+	__m128i h = ic_gcm_reverse(_mm_loadu_si128((const __m128i*)gcm->H));
+	__m128i p = h;
+	for (int i = 0; i < 4; i++)
+	{
+		_mm_storeu_si128((__m128i*)gcm->HP[i], p);
+		p = ic_gcm_mul(p, h);
+	}
+	return CRYPT_OK;
+}
+
+static void ic_gcm_mult_h(const gcm_state* gcm, unsigned char* I)
+{
+	__m128i x = ic_gcm_reverse(_mm_loadu_si128((const __m128i*)I));
+	x = ic_gcm_mul(x, _mm_loadu_si128((const __m128i*)gcm->HP[0]));
+	_mm_storeu_si128((__m128i*)I, ic_gcm_reverse(x));
+}
+
+// One block through the AES-NI round keys
+static __m128i ic_gcm_aes(__m128i b, const __m128i* rk, int nr)
+{
+	b = _mm_xor_si128(b, _mm_loadu_si128(rk));
+	for (int r = 1; r < nr; r++)
+	{
+		b = _mm_aesenc_si128(b, _mm_loadu_si128(rk + r));
+	}
+	return _mm_aesenclast_si128(b, _mm_loadu_si128(rk + nr));
+}
+
+// gcm_process for whole blocks with an empty buf: counter mode on the last 32 bits of Y, then X
+// absorbs each ciphertext block and is multiplied by H. Four blocks are encrypted side by side and
+// hashed as ((X + C1) H^4 + C2 H^3 + C3 H^2 + C4 H) with a single reduction.
+static int ic_gcm_process(gcm_state* gcm, unsigned char* pt, unsigned char* ct, unsigned long blocks, int direction)
+{
+	if (cipher_descriptor[gcm->cipher].ecb_encrypt != ic_aesni_desc.ecb_encrypt)
+	{
+		return CRYPT_NOP;
+	}
+
+	const __m128i* rk = (const __m128i*)gcm->K.rijndael.eK;
+	int nr = gcm->K.rijndael.Nr;
+	bool encrypt = direction == GCM_ENCRYPT;
+	const unsigned char* in = encrypt ? pt : ct;
+	unsigned char* out = encrypt ? ct : pt;
+	gcm->pttotlen += (ulong64)blocks * 128;
+
+	// Y with its counter word in native order, so that _mm_add_epi32 is the 32-bit increment
+	const __m128i swap32 = _mm_set_epi8(12, 13, 14, 15, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	const __m128i one = _mm_set_epi32(1, 0, 0, 0);
+	__m128i y = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)gcm->Y), swap32);
+	__m128i x = ic_gcm_reverse(_mm_loadu_si128((const __m128i*)gcm->X));
+	__m128i h1 = _mm_loadu_si128((const __m128i*)gcm->HP[0]);
+	__m128i h2 = _mm_loadu_si128((const __m128i*)gcm->HP[1]);
+	__m128i h3 = _mm_loadu_si128((const __m128i*)gcm->HP[2]);
+	__m128i h4 = _mm_loadu_si128((const __m128i*)gcm->HP[3]);
+
+	for (; blocks >= 4; blocks -= 4, in += 64, out += 64)
+	{
+		__m128i k = _mm_loadu_si128(rk);
+		__m128i b0 = _mm_xor_si128(_mm_shuffle_epi8(y, swap32), k);
+		y = _mm_add_epi32(y, one);
+		__m128i b1 = _mm_xor_si128(_mm_shuffle_epi8(y, swap32), k);
+		y = _mm_add_epi32(y, one);
+		__m128i b2 = _mm_xor_si128(_mm_shuffle_epi8(y, swap32), k);
+		y = _mm_add_epi32(y, one);
+		__m128i b3 = _mm_xor_si128(_mm_shuffle_epi8(y, swap32), k);
+		y = _mm_add_epi32(y, one);
+		for (int r = 1; r < nr; r++)
+		{
+			k = _mm_loadu_si128(rk + r);
+			b0 = _mm_aesenc_si128(b0, k);
+			b1 = _mm_aesenc_si128(b1, k);
+			b2 = _mm_aesenc_si128(b2, k);
+			b3 = _mm_aesenc_si128(b3, k);
+		}
+		k = _mm_loadu_si128(rk + nr);
+		__m128i d0 = _mm_loadu_si128((const __m128i*)in);
+		__m128i d1 = _mm_loadu_si128((const __m128i*)(in + 16));
+		__m128i d2 = _mm_loadu_si128((const __m128i*)(in + 32));
+		__m128i d3 = _mm_loadu_si128((const __m128i*)(in + 48));
+		b0 = _mm_xor_si128(_mm_aesenclast_si128(b0, k), d0);
+		b1 = _mm_xor_si128(_mm_aesenclast_si128(b1, k), d1);
+		b2 = _mm_xor_si128(_mm_aesenclast_si128(b2, k), d2);
+		b3 = _mm_xor_si128(_mm_aesenclast_si128(b3, k), d3);
+		_mm_storeu_si128((__m128i*)out, b0);
+		_mm_storeu_si128((__m128i*)(out + 16), b1);
+		_mm_storeu_si128((__m128i*)(out + 32), b2);
+		_mm_storeu_si128((__m128i*)(out + 48), b3);
+
+		__m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+		ic_gcm_clmul(_mm_xor_si128(x, ic_gcm_reverse(encrypt ? b0 : d0)), h4, &lo, &hi);
+		ic_gcm_clmul(ic_gcm_reverse(encrypt ? b1 : d1), h3, &lo, &hi);
+		ic_gcm_clmul(ic_gcm_reverse(encrypt ? b2 : d2), h2, &lo, &hi);
+		ic_gcm_clmul(ic_gcm_reverse(encrypt ? b3 : d3), h1, &lo, &hi);
+		x = ic_gcm_reduce(lo, hi);
+	}
+	for (; blocks > 0; blocks--, in += 16, out += 16)
+	{
+		__m128i d = _mm_loadu_si128((const __m128i*)in);
+		__m128i b = _mm_xor_si128(ic_gcm_aes(_mm_shuffle_epi8(y, swap32), rk, nr), d);
+		y = _mm_add_epi32(y, one);
+		_mm_storeu_si128((__m128i*)out, b);
+		x = ic_gcm_mul(_mm_xor_si128(x, ic_gcm_reverse(encrypt ? b : d)), h1);
+	}
+
+	// As gcm_process leaves it: Y at the next counter and buf holding its key stream
+	y = _mm_shuffle_epi8(y, swap32);
+	_mm_storeu_si128((__m128i*)gcm->Y, y);
+	_mm_storeu_si128((__m128i*)gcm->buf, ic_gcm_aes(y, rk, nr));
+	_mm_storeu_si128((__m128i*)gcm->X, ic_gcm_reverse(x));
+	return CRYPT_OK;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+static const ltc_gcm_accel_descriptor ic_gcm_pclmul_desc =
+{
+	"pclmul",
+	ic_gcm_init,
+	ic_gcm_mult_h,
+	ic_gcm_process
+};
+#endif
+
+const ltc_gcm_accel_descriptor* ic_gcm_accel(void)
+{
+#ifdef IC_CPU_X86
+	if (ic_cpu_features() & IC_CPU_PCLMUL)
+	{
+		return &ic_gcm_pclmul_desc;
+	}
+#endif
+	return 0;
+}
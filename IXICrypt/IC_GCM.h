@@ -0,0 +1,11 @@
+#pragma once
+
+#include "IC_CPU.h"
+#include <tomcrypt.h>
+
+/*
+* GHASH on PCLMULQDQ for libtomcrypt's GCM, to set as ltc_gcm_accel; 0 when the CPU has no carry-less
+* multiply. States keep H^1..H^4 instead of the 64 KiB tables, and text is hashed four blocks per
+* reduction. With ic_aesni_desc as the cipher, gcm_process runs the counter mode and the GHASH in one pass.
+*/
+const ltc_gcm_accel_descriptor* ic_gcm_accel(void);
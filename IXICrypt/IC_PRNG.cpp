@@ -8,6 +8,7 @@ IC_PRNG::IC_PRNG()
 	currentBuffer = 0;
 	currentIndex = 0;
 	currentKey = 0;
+	stream = 0;
 }
 
 IC_PRNG::~IC_PRNG()
@@ -16,13 +17,14 @@ IC_PRNG::~IC_PRNG()
 	dropEntropy();
 }
 
-int IC_PRNG::setEntropy(unsigned char* entropy_data, unsigned int entropy_len)
+int IC_PRNG::setEntropy(unsigned char* entropy_data, unsigned int entropy_len, unsigned int stream_id)
 {
 	dropGenerator();
 	dropEntropy();
 	if (entropy_len % 64 != 0) return -1;
 	if (entropy_len == 0) return -1;
 	stateLen = entropy_len;
+	stream = stream_id;
 	currentRandomState = new unsigned char[stateLen];
 	memcpy(currentRandomState, entropy_data, stateLen);
 	constructGenerator();
@@ -44,7 +46,7 @@ void IC_PRNG::getBytes(unsigned char* out_buffer, unsigned int len)
 	unsigned int cpos = 0;
 	while (cpos < len)
 	{
-		unsigned int avail = 16 - currentIndex;
+		unsigned int avail = IC_PRNG_BUFFER_SIZE - currentIndex;
 		unsigned int need = len - cpos;
 		//printf("-> Available in buffer: %d. Still needed: %d\n", avail, need);
 		if (need <= avail) 
@@ -76,6 +78,9 @@ int IC_PRNG::constructGenerator()
 	tomCipher = new symmetric_CTR;
 	unsigned char IV[16];
 	memset(IV, 0, 16);
+	// The counter counts up from the low bytes, so a stream id in the high ones
+	// keeps the streams' counter blocks apart
+	STORE32H(stream, IV + 12);
 	//printf("Calling libtomcrypt ctr cipher...\n");
 	int r = ctr_start(cipher, IV, currentRandomState, 16, 0, LTC_CTR_RFC3686, tomCipher);
 	//printf("Call returns: %d.\n", r);
@@ -110,13 +115,28 @@ void IC_PRNG::generateBlock()
 {
 	//printf("Generating AES-CTR block... Current key offset: %d / %d\n", currentKey, stateLen);
 	if (currentBuffer == 0) {
-		currentBuffer = new unsigned char[16];
+		currentBuffer = new unsigned char[IC_PRNG_BUFFER_SIZE];
 	}
-	currentKey += 16;
-	if (currentKey >= stateLen)
+	// Each 16-byte block encrypts the next 16 bytes of the entropy state, wrapping
+	// around at its end; lay out the plaintext for the whole buffer, in runs that
+	// end at the wrap, and encrypt it in one call
+	unsigned int pos = 0;
+	while (pos < IC_PRNG_BUFFER_SIZE)
 	{
-		currentKey = 0;
+		unsigned int start = currentKey + 16;
+		if (start >= stateLen)
+		{
+			start = 0;
+		}
+		unsigned int run = stateLen - start;
+		if (run > IC_PRNG_BUFFER_SIZE - pos)
+		{
+			run = IC_PRNG_BUFFER_SIZE - pos;
+		}
+		memcpy(currentBuffer + pos, currentRandomState + start, run);
+		pos += run;
+		currentKey = start + run - 16;
 	}
-	ctr_encrypt(currentRandomState + currentKey, currentBuffer, 16, tomCipher);
+	ctr_encrypt(currentBuffer, currentBuffer, IC_PRNG_BUFFER_SIZE, tomCipher);
 	currentIndex = 0;
 }
\ No newline at end of file
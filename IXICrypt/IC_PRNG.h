@@ -3,6 +3,9 @@
 #include <string.h>
 #include <tomcrypt.h>
 
+// Keystream generated per refill; a multiple of the AES block size
+#define IC_PRNG_BUFFER_SIZE 4096
+
 class IC_PRNG {
 private:
 	unsigned char *currentRandomState;
@@ -11,6 +14,7 @@ private:
 	unsigned char* currentBuffer;
 	unsigned int currentIndex;
 	unsigned int currentKey;
+	unsigned int stream;
 public:
 	IC_PRNG();
 	~IC_PRNG();
@@ -19,8 +23,11 @@ public:
 	* Returns:
 	* 0		- OK
 	* -1	- invalid length (must be %64)
+	*
+	* Each stream id gives an independent keystream of the same entropy; stream 0 is the one
+	* key derivation has always used.
 	*/
-	int setEntropy(unsigned char* entropy_data, unsigned int entropy_len);
+	int setEntropy(unsigned char* entropy_data, unsigned int entropy_len, unsigned int stream_id = 0);
 	void dropEntropy();
 	/*
 	* Returns: 
@@ -40,6 +47,8 @@ private:
 	*/
 	int constructGenerator();
 	void dropGenerator();
+	// Refills currentBuffer with the next IC_PRNG_BUFFER_SIZE bytes, the same bytes
+	// as that many successive 16-byte blocks
 	void generateBlock();
 };
 
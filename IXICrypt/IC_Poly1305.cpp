@@ -0,0 +1,335 @@
+#include "IC_Poly1305.h"
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#define IC_POLY1305_64
+#elif defined(__SIZEOF_INT128__)
+#define IC_POLY1305_64
+#endif
+
+#ifdef IC_POLY1305_64
+#ifdef IC_CPU_X86
+#include <immintrin.h>
+#endif
+
+// 128-bit products and sums of them
+#if defined(_MSC_VER)
+struct ic_u128
+{
+	ulong64 lo, hi;
+};
+
+static ic_u128 ic_from64(ulong64 a)
+{
+	ic_u128 r;
+	r.lo = a;
+	r.hi = 0;
+	return r;
+}
+
+static ic_u128 ic_mul64(ulong64 a, ulong64 b)
+{
+	ic_u128 r;
+	r.lo = _umul128(a, b, &r.hi);
+	return r;
+}
+
+static ic_u128 ic_add128(ic_u128 a, ic_u128 b)
+{
+	ic_u128 r;
+	_addcarry_u64(_addcarry_u64(0, a.lo, b.lo, &r.lo), a.hi, b.hi, &r.hi);
+	return r;
+}
+
+static ulong64 ic_shr128(ic_u128 a, int n)
+{
+	return __shiftright128(a.lo, a.hi, (unsigned char)n);
+}
+
+static ulong64 ic_lo128(ic_u128 a)
+{
+	return a.lo;
+}
+#else
+typedef unsigned __int128 ic_u128;
+
+static ic_u128 ic_from64(ulong64 a)
+{
+	return a;
+}
+
+static ic_u128 ic_mul64(ulong64 a, ulong64 b)
+{
+	return (ic_u128)a * b;
+}
+
+static ic_u128 ic_add128(ic_u128 a, ic_u128 b)
+{
+	return a + b;
+}
+
+static ulong64 ic_shr128(ic_u128 a, int n)
+{
+	return (ulong64)(a >> n);
+}
+
+static ulong64 ic_lo128(ic_u128 a)
+{
+	return (ulong64)a;
+}
+#endif
+
+static const ulong64 ic_mask26 = 0x3ffffff;
+static const ulong64 ic_mask42 = CONST64(0x3ffffffffff);
+static const ulong64 ic_mask44 = CONST64(0xfffffffffff);
+
+// The 26-bit limbs of poly1305_state as limbs of 44, 44 and 42 bits
+static void ic_poly1305_from26(const ulong32* v, ulong64* g)
+{
+	ulong64 t = v[0] + ((ulong64)v[1] << 26);
+	g[0] = t & ic_mask44;
+	t = (t >> 44) + ((ulong64)v[2] << 8) + ((ulong64)v[3] << 34);
+	g[1] = t & ic_mask44;
+	g[2] = (t >> 44) + ((ulong64)v[4] << 16);
+}
+
+// Back to 26-bit limbs, carried as _poly1305_block leaves them
+static void ic_poly1305_to26(const ulong64* g, ulong32* v)
+{
+	ulong64 t = g[0];
+	ulong64 h[5];
+	h[0] = t & ic_mask26;
+	t = (t >> 26) + (g[1] << 18);
+	h[1] = t & ic_mask26;
+	t >>= 26;
+	h[2] = t & ic_mask26;
+	t = (t >> 26) + (g[2] << 10);
+	h[3] = t & ic_mask26;
+	t >>= 26;
+	h[4] = t & ic_mask26;
+	h[0] += (t >> 26) * 5;
+	h[1] += h[0] >> 26;
+	h[0] &= ic_mask26;
+	for (int i = 0; i < 5; i++)
+	{
+		v[i] = (ulong32)h[i];
+	}
+}
+
+// h = h * r, partially reduced modulo 2^130 - 5; 2^132 is 4 * 5 modulo it
+static void ic_poly1305_mul44(ulong64* h, const ulong64* r)
+{
+	ulong64 s1 = r[1] * 20, s2 = r[2] * 20;
+	ic_u128 d0 = ic_add128(ic_add128(ic_mul64(h[0], r[0]), ic_mul64(h[1], s2)), ic_mul64(h[2], s1));
+	ic_u128 d1 = ic_add128(ic_add128(ic_mul64(h[0], r[1]), ic_mul64(h[1], r[0])), ic_mul64(h[2], s2));
+	ic_u128 d2 = ic_add128(ic_add128(ic_mul64(h[0], r[2]), ic_mul64(h[1], r[1])), ic_mul64(h[2], r[0]));
+
+	ulong64 c = ic_shr128(d0, 44);
+	h[0] = ic_lo128(d0) & ic_mask44;
+	d1 = ic_add128(d1, ic_from64(c));
+	c = ic_shr128(d1, 44);
+	h[1] = ic_lo128(d1) & ic_mask44;
+	d2 = ic_add128(d2, ic_from64(c));
+	c = ic_shr128(d2, 42);
+	h[2] = ic_lo128(d2) & ic_mask42;
+	h[0] += c * 5;
+	c = h[0] >> 44;
+	h[0] &= ic_mask44;
+	h[1] += c;
+}
+
+static void ic_poly1305_blocks64(poly1305_state* st, const unsigned char* in, unsigned long inlen)
+{
+	ulong64 h[3], r[3];
+	ic_poly1305_from26(st->h, h);
+	ic_poly1305_from26(st->r, r);
+
+	for (; inlen >= 16; inlen -= 16, in += 16)
+	{
+		ulong64 t0, t1;
+		LOAD64L(t0, in);
+		LOAD64L(t1, in + 8);
+		h[0] += t0 & ic_mask44;
+		h[1] += ((t0 >> 44) | (t1 << 20)) & ic_mask44;
+		h[2] += ((t1 >> 24) & ic_mask42) | ((ulong64)1 << 40);
+		ic_poly1305_mul44(h, r);
+	}
+
+	ic_poly1305_to26(h, st->h);
+}
+
+#ifdef IC_CPU_X86
+// As in IC_SHA512.cpp, compiled for AVX2 and only called once ic_cpu_features reports it
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+// h = h * r in 26-bit limbs, one number per 64-bit lane, with s = 5 * r; partially reduced
+static void ic_poly1305_mul_avx2(__m256i* h, const __m256i* r, const __m256i* s)
+{
+	__m256i d0 = _mm256_mul_epu32(h[0], r[0]);
+	__m256i d1 = _mm256_mul_epu32(h[0], r[1]);
+	__m256i d2 = _mm256_mul_epu32(h[0], r[2]);
+	__m256i d3 = _mm256_mul_epu32(h[0], r[3]);
+	__m256i d4 = _mm256_mul_epu32(h[0], r[4]);
+	d0 = _mm256_add_epi64(d0, _mm256_mul_epu32(h[1], s[4]));
+	d1 = _mm256_add_epi64(d1, _mm256_mul_epu32(h[1], r[0]));
+	d2 = _mm256_add_epi64(d2, _mm256_mul_epu32(h[1], r[1]));
+	d3 = _mm256_add_epi64(d3, _mm256_mul_epu32(h[1], r[2]));
+	d4 = _mm256_add_epi64(d4, _mm256_mul_epu32(h[1], r[3]));
+	d0 = _mm256_add_epi64(d0, _mm256_mul_epu32(h[2], s[3]));
+	d1 = _mm256_add_epi64(d1, _mm256_mul_epu32(h[2], s[4]));
+	d2 = _mm256_add_epi64(d2, _mm256_mul_epu32(h[2], r[0]));
+	d3 = _mm256_add_epi64(d3, _mm256_mul_epu32(h[2], r[1]));
+	d4 = _mm256_add_epi64(d4, _mm256_mul_epu32(h[2], r[2]));
+	d0 = _mm256_add_epi64(d0, _mm256_mul_epu32(h[3], s[2]));
+	d1 = _mm256_add_epi64(d1, _mm256_mul_epu32(h[3], s[3]));
+	d2 = _mm256_add_epi64(d2, _mm256_mul_epu32(h[3], s[4]));
+	d3 = _mm256_add_epi64(d3, _mm256_mul_epu32(h[3], r[0]));
+	d4 = _mm256_add_epi64(d4, _mm256_mul_epu32(h[3], r[1]));
+	d0 = _mm256_add_epi64(d0, _mm256_mul_epu32(h[4], s[1]));
+	d1 = _mm256_add_epi64(d1, _mm256_mul_epu32(h[4], s[2]));
+	d2 = _mm256_add_epi64(d2, _mm256_mul_epu32(h[4], s[3]));
+	d3 = _mm256_add_epi64(d3, _mm256_mul_epu32(h[4], s[4]));
+	d4 = _mm256_add_epi64(d4, _mm256_mul_epu32(h[4], r[0]));
+
+	const __m256i mask = _mm256_set1_epi64x(ic_mask26);
+	d1 = _mm256_add_epi64(d1, _mm256_srli_epi64(d0, 26));
+	d2 = _mm256_add_epi64(d2, _mm256_srli_epi64(d1, 26));
+	d3 = _mm256_add_epi64(d3, _mm256_srli_epi64(d2, 26));
+	d4 = _mm256_add_epi64(d4, _mm256_srli_epi64(d3, 26));
+	__m256i c = _mm256_srli_epi64(d4, 26);
+	d0 = _mm256_add_epi64(_mm256_and_si256(d0, mask), _mm256_add_epi64(c, _mm256_slli_epi64(c, 2)));
+	h[0] = _mm256_and_si256(d0, mask);
+	h[1] = _mm256_add_epi64(_mm256_and_si256(d1, mask), _mm256_srli_epi64(d0, 26));
+	h[2] = _mm256_and_si256(d2, mask);
+	h[3] = _mm256_and_si256(d3, mask);
+	h[4] = _mm256_and_si256(d4, mask);
+}
+
+static void ic_poly1305_times5_avx2(const __m256i* r, __m256i* s)
+{
+	for (int i = 0; i < 5; i++)
+	{
+		s[i] = _mm256_add_epi64(r[i], _mm256_slli_epi64(r[i], 2));
+	}
+}
+
+// Four interleaved Poly1305 sums: lane j takes every fourth block, and is multiplied by r^4 per
+// block instead of r, except after its last block, where the lane of the i-th block of the group
+// is multiplied by r^(4 - i) so that the lanes add up to the sequential result. Takes whole
+// groups of four blocks; h starts in the lane of the first block.
+static void ic_poly1305_blocks_avx2(poly1305_state* st, const unsigned char* in, unsigned long groups)
+{
+	ulong64 p[4][3];
+	ulong32 r26[4][5];
+	ic_poly1305_from26(st->r, p[0]);
+	for (int i = 1; i < 4; i++)
+	{
+		p[i][0] = p[i - 1][0];
+		p[i][1] = p[i - 1][1];
+		p[i][2] = p[i - 1][2];
+		ic_poly1305_mul44(p[i], p[0]);
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		ic_poly1305_to26(p[i], r26[i]);
+	}
+
+	// Unpacking two blocks per register puts the blocks of a group in lanes 0, 2, 1, 3
+	__m256i r4[5], s4[5], rl[5], sl[5], h[5];
+	for (int i = 0; i < 5; i++)
+	{
+		r4[i] = _mm256_set1_epi64x(r26[3][i]);
+		rl[i] = _mm256_set_epi64x(r26[0][i], r26[2][i], r26[1][i], r26[3][i]);
+		h[i] = _mm256_set_epi64x(0, 0, 0, st->h[i]);
+	}
+	ic_poly1305_times5_avx2(r4, s4);
+	ic_poly1305_times5_avx2(rl, sl);
+
+	const __m256i mask = _mm256_set1_epi64x(ic_mask26);
+	const __m256i hibit = _mm256_set1_epi64x(1 << 24);
+	for (; groups > 0; groups--, in += 64)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i*)in);
+		__m256i b = _mm256_loadu_si256((const __m256i*)(in + 32));
+		__m256i lo = _mm256_unpacklo_epi64(a, b);
+		__m256i hi = _mm256_unpackhi_epi64(a, b);
+		h[0] = _mm256_add_epi64(h[0], _mm256_and_si256(lo, mask));
+		h[1] = _mm256_add_epi64(h[1], _mm256_and_si256(_mm256_srli_epi64(lo, 26), mask));
+		h[2] = _mm256_add_epi64(h[2], _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(lo, 52), _mm256_slli_epi64(hi, 12)), mask));
+		h[3] = _mm256_add_epi64(h[3], _mm256_and_si256(_mm256_srli_epi64(hi, 14), mask));
+		h[4] = _mm256_add_epi64(h[4], _mm256_or_si256(_mm256_srli_epi64(hi, 40), hibit));
+		if (groups > 1)
+		{
+			ic_poly1305_mul_avx2(h, r4, s4);
+		}
+		else
+		{
+			ic_poly1305_mul_avx2(h, rl, sl);
+		}
+	}
+
+	ulong64 lanes[4], sum[5];
+	for (int i = 0; i < 5; i++)
+	{
+		_mm256_storeu_si256((__m256i*)lanes, h[i]);
+		sum[i] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+	ulong64 c = sum[0] >> 26;
+	sum[0] &= ic_mask26;
+	for (int i = 1; i < 5; i++)
+	{
+		sum[i] += c;
+		c = sum[i] >> 26;
+		sum[i] &= ic_mask26;
+	}
+	sum[0] += c * 5;
+	sum[1] += sum[0] >> 26;
+	sum[0] &= ic_mask26;
+	for (int i = 0; i < 5; i++)
+	{
+		st->h[i] = (ulong32)sum[i];
+	}
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
+
+static void ic_poly1305_blocks(poly1305_state* st, const unsigned char* in, unsigned long inlen)
+{
+#ifdef IC_CPU_X86
+	// Below the threshold, computing r^2..r^4 costs more than the four lanes save
+	if (inlen >= IC_POLY1305_AVX2_MIN && (ic_cpu_features() & IC_CPU_AVX2))
+	{
+		unsigned long groups = inlen / 64;
+		ic_poly1305_blocks_avx2(st, in, groups);
+		in += groups * 64;
+		inlen -= groups * 64;
+	}
+#endif
+	ic_poly1305_blocks64(st, in, inlen);
+}
+
+static const ltc_poly1305_accel_descriptor ic_poly1305_64_desc =
+{
+	"64-bit",
+	ic_poly1305_blocks
+};
+#endif
+
+const ltc_poly1305_accel_descriptor* ic_poly1305_accel(void)
+{
+#ifdef IC_POLY1305_64
+	return &ic_poly1305_64_desc;
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "IC_CPU.h"
+#include <tomcrypt.h>
+
+/*
+* Poly1305 for libtomcrypt, to set as ltc_poly1305_accel; 0 where the compiler has no 64x64-bit
+* multiply. Blocks are absorbed in 44-bit limbs with 128-bit products, and runs of at least
+* IC_POLY1305_AVX2_MIN bytes four blocks at a time with AVX2, using r^2..r^4.
+*/
+#define IC_POLY1305_AVX2_MIN	256
+
+const ltc_poly1305_accel_descriptor* ic_poly1305_accel(void);
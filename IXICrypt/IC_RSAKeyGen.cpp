@@ -0,0 +1,174 @@
+#include "IC_RSAKeyGen.h"
+#include "IC_PRNG.h"
+#include <climits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define IC_RSA_STREAM_P 1
+#define IC_RSA_STREAM_Q 2
+
+// The search for one prime. Candidates are claimed in stream order; once one passes, nothing
+// after it is claimed, and everything before it was claimed already, so when all workers are
+// done the lowest passing index is the stream's first valid candidate.
+struct IC_PrimeSearch
+{
+	IC_PRNG prng;
+	long len;
+	long e;
+	std::mutex lock;
+	long next;
+	long found;
+	std::vector<unsigned char> winner;
+	int err;
+};
+
+static void ic_prime_search_worker(IC_PrimeSearch* s)
+{
+	void *tester = 0, *x = 0, *tmp1 = 0, *tmp2 = 0, *ev = 0;
+	std::vector<unsigned char> buf(s->len);
+	bool have_numbers = false;
+
+	int err = rand_prime_tester_init(&tester, s->len);
+	if (err == CRYPT_OK)
+	{
+		err = ltc_init_multi(&x, &tmp1, &tmp2, &ev, NULL);
+		have_numbers = err == CRYPT_OK;
+	}
+	if (err == CRYPT_OK)
+	{
+		err = ltc_mp.set_int(ev, s->e);
+	}
+	while (err == CRYPT_OK)
+	{
+		long index;
+		{
+			std::lock_guard<std::mutex> guard(s->lock);
+			if (s->err != CRYPT_OK || s->found < s->next)
+			{
+				break;
+			}
+			index = s->next++;
+			s->prng.getBytes(buf.data(), (unsigned int)s->len);
+		}
+
+		int res;
+		if ((err = rand_prime_test(tester, buf.data(), x, &res)) != CRYPT_OK || res != LTC_MP_YES)
+		{
+			continue;
+		}
+		// e must not divide x-1
+		if ((err = ltc_mp.subi(x, 1, tmp1)) != CRYPT_OK || (err = ltc_mp.gcd(tmp1, ev, tmp2)) != CRYPT_OK || ltc_mp.compare_d(tmp2, 1) != LTC_MP_EQ)
+		{
+			continue;
+		}
+
+		std::lock_guard<std::mutex> guard(s->lock);
+		if (index < s->found)
+		{
+			s->found = index;
+			s->winner = buf;
+		}
+	}
+	if (err != CRYPT_OK)
+	{
+		std::lock_guard<std::mutex> guard(s->lock);
+		if (s->err == CRYPT_OK)
+		{
+			s->err = err;
+		}
+	}
+
+	zeromem(buf.data(), buf.size());
+	if (have_numbers)
+	{
+		ltc_deinit_multi(ev, tmp2, tmp1, x, NULL);
+	}
+	rand_prime_tester_done(tester);
+}
+
+static void ic_prime_search(IC_PrimeSearch* s, unsigned int threads)
+{
+	std::vector<std::thread> pool;
+	for (unsigned int t = 1; t < threads; t++)
+	{
+		pool.emplace_back(ic_prime_search_worker, s);
+	}
+	ic_prime_search_worker(s);
+	for (std::thread& t : pool)
+	{
+		t.join();
+	}
+}
+
+static int ic_prime_search_start(IC_PrimeSearch* s, unsigned char* entropy, unsigned int entropy_len, unsigned int stream_id, long len, long e)
+{
+	if (s->prng.setEntropy(entropy, entropy_len, stream_id) != 0)
+	{
+		return CRYPT_INVALID_ARG;
+	}
+	s->len = len;
+	s->e = e;
+	s->next = 0;
+	s->found = LONG_MAX;
+	s->err = CRYPT_OK;
+	return CRYPT_OK;
+}
+
+int ic_rsa_make_key_v2(unsigned char* entropy, unsigned int entropy_len, int size, long e, rsa_key* key, unsigned int threads)
+{
+	if (entropy == 0 || key == 0 || size <= 0 || e < 3 || (e & 1) == 0)
+	{
+		return CRYPT_INVALID_ARG;
+	}
+	if (threads == 0)
+	{
+		threads = std::thread::hardware_concurrency();
+	}
+
+	IC_PrimeSearch p_search, q_search;
+	int err;
+	if ((err = ic_prime_search_start(&p_search, entropy, entropy_len, IC_RSA_STREAM_P, size / 2, e)) != CRYPT_OK
+		|| (err = ic_prime_search_start(&q_search, entropy, entropy_len, IC_RSA_STREAM_Q, size / 2, e)) != CRYPT_OK)
+	{
+		return err;
+	}
+
+	// Half the threads each, at least one per prime
+	unsigned int p_threads = threads / 2 + threads % 2;
+	unsigned int q_threads = threads / 2;
+	std::thread p_thread(ic_prime_search, &p_search, p_threads > 0 ? p_threads : 1);
+	ic_prime_search(&q_search, q_threads > 0 ? q_threads : 1);
+	p_thread.join();
+	if (p_search.err != CRYPT_OK)
+	{
+		err = p_search.err;
+	}
+	else if (q_search.err != CRYPT_OK)
+	{
+		err = q_search.err;
+	}
+	else
+	{
+		void *p, *q;
+		if ((err = ltc_init_multi(&p, &q, NULL)) == CRYPT_OK)
+		{
+			if ((err = ltc_mp.unsigned_read(p, p_search.winner.data(), (unsigned long)p_search.len)) == CRYPT_OK
+				&& (err = ltc_mp.unsigned_read(q, q_search.winner.data(), (unsigned long)q_search.len)) == CRYPT_OK)
+			{
+				err = rsa_make_key_from_primes(p, q, e, key);
+			}
+			ltc_deinit_multi(q, p, NULL);
+		}
+	}
+
+	if (!p_search.winner.empty())
+	{
+		zeromem(p_search.winner.data(), p_search.winner.size());
+	}
+	if (!q_search.winner.empty())
+	{
+		zeromem(q_search.winner.data(), q_search.winner.size());
+	}
+	return err;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <tomcrypt.h>
+
+/*
+* Key generation version 2. p and q come from two independent IC_PRNG streams of the entropy
+* (stream ids 1 and 2; version 1 reads both from stream 0) and are searched for at the same time,
+* each by several threads testing consecutive candidates. Each prime is the first candidate of its
+* stream that rand_prime accepts and for which gcd(x-1, e) == 1, the rule rsa_make_key applies, so
+* the key only depends on the entropy and not on the number of threads.
+* threads == 0 uses every core.
+* Returns a CRYPT_* code; on CRYPT_OK the key must be released with rsa_free.
+*/
+int ic_rsa_make_key_v2(unsigned char* entropy, unsigned int entropy_len, int size, long e, rsa_key* key, unsigned int threads);
@@ -0,0 +1,307 @@
+#include "IC_RSASign.h"
+#include "IC_RSAVerify.h"
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// tfm.h has no C++ guards of its own
+extern "C"
+{
+#include <tfm.h>
+}
+
+// A modulus with its Montgomery setup
+struct IC_MontModulus
+{
+	fp_int m;
+	fp_int rr; // R^2 mod m
+	fp_digit mp;
+};
+
+struct IC_RSASigner
+{
+	IC_MontModulus n, p, q;
+	fp_int e, dP, dQ;
+	fp_int qP; // q^-1 mod p, in Montgomery form
+	unsigned long size; // bytes of n, and of every signature
+	bool parallel;
+#ifdef LTC_RSA_BLINDING
+	std::mutex lock;
+	fp_int blind; // r^e mod n, in Montgomery form
+	fp_int unblind; // r^-1 mod n, in Montgomery form
+#endif
+
+	// Every field but the mutex is wiped; R^2 mod p alone would give away p
+	~IC_RSASigner()
+	{
+		zeromem(&n, sizeof(n));
+		zeromem(&p, sizeof(p));
+		zeromem(&q, sizeof(q));
+		zeromem(&e, sizeof(e));
+		zeromem(&dP, sizeof(dP));
+		zeromem(&dQ, sizeof(dQ));
+		zeromem(&qP, sizeof(qP));
+		zeromem(&size, sizeof(size));
+		zeromem(&parallel, sizeof(parallel));
+#ifdef LTC_RSA_BLINDING
+		zeromem(&blind, sizeof(blind));
+		zeromem(&unblind, sizeof(unblind));
+#endif
+	}
+};
+
+static int ic_mont_setup(IC_MontModulus* mod, fp_int* m)
+{
+	fp_init_copy(&mod->m, m);
+	fp_init(&mod->rr);
+	if (fp_montgomery_setup(m, &mod->mp) != FP_OKAY)
+	{
+		return CRYPT_INVALID_ARG;
+	}
+	fp_montgomery_calc_normalization(&mod->rr, m);
+	return fp_sqrmod(&mod->rr, m, &mod->rr) == FP_OKAY ? CRYPT_OK : CRYPT_ERROR;
+}
+
+// c = a * b / R mod m, for a and b below m
+static void ic_mont_mul(IC_MontModulus* mod, fp_int* a, fp_int* b, fp_int* c)
+{
+	fp_mul(a, b, c);
+	fp_montgomery_reduce(c, &mod->m, mod->mp);
+}
+
+// c = a * R mod m, for a below m
+static void ic_mont_to(IC_MontModulus* mod, fp_int* a, fp_int* c)
+{
+	ic_mont_mul(mod, a, &mod->rr, c);
+}
+
+// rsa_import for PKCS#1, otherwise the Ixian format: modulus, exponent, P, Q, DP, DQ, InverseQ, D
+static int ic_rsa_import_private(const unsigned char* key, unsigned int key_len, rsa_key* tc_key)
+{
+	int err;
+	if (rsa_import(key, key_len, tc_key) == CRYPT_OK)
+	{
+		if (tc_key->type == PK_PRIVATE)
+		{
+			return CRYPT_OK;
+		}
+		rsa_free(tc_key);
+		return CRYPT_PK_NOT_PRIVATE;
+	}
+
+	const unsigned char* fields[8];
+	unsigned int lens[8];
+	if (!ic_rsa_key_fields(key, key_len, 8, fields, lens))
+	{
+		return CRYPT_INVALID_PACKET;
+	}
+	if ((err = rsa_set_key(fields[0], lens[0], fields[1], lens[1], fields[7], lens[7], tc_key)) != CRYPT_OK)
+	{
+		return err;
+	}
+	if ((err = rsa_set_factors(fields[2], lens[2], fields[3], lens[3], tc_key)) != CRYPT_OK
+		|| (err = rsa_set_crt_params(fields[4], lens[4], fields[5], lens[5], fields[6], lens[6], tc_key)) != CRYPT_OK)
+	{
+		rsa_free(tc_key);
+		return err;
+	}
+	return CRYPT_OK;
+}
+
+#ifdef LTC_RSA_BLINDING
+// Draws r and sets the blinding pair from it
+static int ic_rsa_blinding_init(IC_RSASigner* signer)
+{
+	std::vector<unsigned char> buf(signer->size);
+	fp_int r;
+	fp_init(&r);
+	for (int tries = 0; tries < 8; tries++)
+	{
+		if (rng_get_bytes(buf.data(), signer->size, NULL) != signer->size)
+		{
+			break;
+		}
+		fp_read_unsigned_bin(&r, buf.data(), (int)signer->size);
+		fp_mod(&r, &signer->n.m, &r);
+		if (fp_iszero(&r) || fp_invmod(&r, &signer->n.m, &signer->unblind) != FP_OKAY
+			|| fp_exptmod_mont(&r, &signer->e, &signer->n.m, signer->n.mp, &signer->n.rr, &signer->blind) != FP_OKAY)
+		{
+			continue;
+		}
+		ic_mont_to(&signer->n, &signer->blind, &signer->blind);
+		ic_mont_to(&signer->n, &signer->unblind, &signer->unblind);
+		zeromem(buf.data(), buf.size());
+		fp_zero(&r);
+		return CRYPT_OK;
+	}
+	zeromem(buf.data(), buf.size());
+	fp_zero(&r);
+	return CRYPT_ERROR_READPRNG;
+}
+#endif
+
+// With tfm_desc the numbers of tc_key are fp_ints
+static int ic_rsa_signer_setup(IC_RSASigner* signer, rsa_key* tc_key)
+{
+	fp_int *n = (fp_int*)tc_key->N, *p = (fp_int*)tc_key->p, *q = (fp_int*)tc_key->q;
+	fp_int qP;
+	int err;
+
+	signer->size = (unsigned long)fp_unsigned_bin_size(n);
+	if (signer->size < IC_RSA_MIN_SIZE || signer->size > (FP_SIZE / 2) * (DIGIT_BIT / 8)
+		|| fp_iszero(p) || fp_iszero(q) || fp_iszero((fp_int*)tc_key->dP) || fp_iszero((fp_int*)tc_key->dQ) || fp_iszero((fp_int*)tc_key->qP))
+	{
+		return CRYPT_INVALID_ARG;
+	}
+	if ((err = ic_mont_setup(&signer->n, n)) != CRYPT_OK
+		|| (err = ic_mont_setup(&signer->p, p)) != CRYPT_OK
+		|| (err = ic_mont_setup(&signer->q, q)) != CRYPT_OK)
+	{
+		return err;
+	}
+	fp_init_copy(&signer->e, (fp_int*)tc_key->e);
+	fp_init_copy(&signer->dP, (fp_int*)tc_key->dP);
+	fp_init_copy(&signer->dQ, (fp_int*)tc_key->dQ);
+	fp_init(&qP);
+	fp_mod((fp_int*)tc_key->qP, p, &qP);
+	fp_init(&signer->qP);
+	ic_mont_to(&signer->p, &qP, &signer->qP);
+	fp_zero(&qP);
+
+	signer->parallel = std::thread::hardware_concurrency() > 1;
+#ifdef LTC_RSA_BLINDING
+	return ic_rsa_blinding_init(signer);
+#else
+	return CRYPT_OK;
+#endif
+}
+
+IC_RSASigner* ic_rsa_signer_open(const unsigned char* key, unsigned int key_len)
+{
+	if (key == 0)
+	{
+		return 0;
+	}
+	rsa_key tc_key;
+	if (ic_rsa_import_private(key, key_len, &tc_key) != CRYPT_OK)
+	{
+		return 0;
+	}
+	IC_RSASigner* signer = new IC_RSASigner();
+	int err = ic_rsa_signer_setup(signer, &tc_key);
+	rsa_free(&tc_key);
+	if (err != CRYPT_OK)
+	{
+		ic_rsa_signer_close(signer);
+		return 0;
+	}
+	return signer;
+}
+
+int ic_rsa_sign(IC_RSASigner* signer, const unsigned char* hash, unsigned int hash_len, unsigned char* sig, unsigned long* sig_len)
+{
+	if (signer == 0 || hash == 0 || sig == 0 || sig_len == 0 || hash_len != IC_SHA512_LEN)
+	{
+		return CRYPT_INVALID_ARG;
+	}
+	if (*sig_len < signer->size)
+	{
+		*sig_len = signer->size;
+		return CRYPT_BUFFER_OVERFLOW;
+	}
+
+	std::vector<unsigned char> em(signer->size);
+	ic_rsa_encode_sha512(hash, signer->size, em.data());
+	fp_int m, x, a, b, t;
+	fp_init(&m);
+	fp_init(&x);
+	fp_init(&a);
+	fp_init(&b);
+	fp_init(&t);
+	fp_read_unsigned_bin(&m, em.data(), (int)signer->size);
+
+#ifdef LTC_RSA_BLINDING
+	fp_int blind, unblind;
+	{
+		std::lock_guard<std::mutex> guard(signer->lock);
+		fp_init_copy(&blind, &signer->blind);
+		fp_init_copy(&unblind, &signer->unblind);
+		// The next pair is this one squared, (r^2)^e and (r^2)^-1
+		ic_mont_mul(&signer->n, &signer->blind, &signer->blind, &signer->blind);
+		ic_mont_mul(&signer->n, &signer->unblind, &signer->unblind, &signer->unblind);
+	}
+	ic_mont_mul(&signer->n, &m, &blind, &x);
+#else
+	fp_copy(&m, &x);
+#endif
+
+	// a = x^dP mod p and b = x^dQ mod q, at the same time
+	int err_p = FP_OKAY, err_q;
+	auto half_p = [&]()
+	{
+		err_p = fp_exptmod_mont(&x, &signer->dP, &signer->p.m, signer->p.mp, &signer->p.rr, &a);
+	};
+	if (signer->parallel)
+	{
+		std::thread thread_p(half_p);
+		err_q = fp_exptmod_mont(&x, &signer->dQ, &signer->q.m, signer->q.mp, &signer->q.rr, &b);
+		thread_p.join();
+	}
+	else
+	{
+		half_p();
+		err_q = fp_exptmod_mont(&x, &signer->dQ, &signer->q.m, signer->q.mp, &signer->q.rr, &b);
+	}
+
+	int err = CRYPT_OK;
+	if (err_p != FP_OKAY || err_q != FP_OKAY)
+	{
+		err = CRYPT_ERROR;
+	}
+	else
+	{
+		// x = b + q * ((a - b) * q^-1 mod p)
+		fp_sub(&a, &b, &t);
+		fp_mod(&t, &signer->p.m, &t);
+		ic_mont_mul(&signer->p, &t, &signer->qP, &t);
+		fp_mul(&t, &signer->q.m, &t);
+		fp_add(&t, &b, &x);
+#ifdef LTC_RSA_BLINDING
+		ic_mont_mul(&signer->n, &x, &unblind, &x);
+#endif
+#ifdef LTC_RSA_CRT_HARDENING
+		if (fp_exptmod_mont(&x, &signer->e, &signer->n.m, signer->n.mp, &signer->n.rr, &t) != FP_OKAY || fp_cmp(&t, &m) != FP_EQ)
+		{
+			err = CRYPT_ERROR;
+		}
+#endif
+	}
+	if (err == CRYPT_OK)
+	{
+		unsigned long x_len = (unsigned long)fp_unsigned_bin_size(&x);
+		zeromem(sig, signer->size);
+		fp_to_unsigned_bin(&x, sig + (signer->size - x_len));
+		*sig_len = signer->size;
+	}
+
+	fp_zero(&m);
+	fp_zero(&a);
+	fp_zero(&b);
+	fp_zero(&t);
+	fp_zero(&x);
+#ifdef LTC_RSA_BLINDING
+	fp_zero(&blind);
+	fp_zero(&unblind);
+#endif
+	return err;
+}
+
+void ic_rsa_signer_close(IC_RSASigner* signer)
+{
+	if (signer == 0)
+	{
+		return;
+	}
+	// The destructor wipes the key
+	delete signer;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <tomcrypt.h>
+
+struct IC_RSASigner;
+
+/*
+* Imports a private key once for any number of signatures. The key is either the PKCS#1 blob of
+* rsa_export, as ix_generate_rsa returns it, or a private key in the Ixian format of
+* BouncyCastle.rsaKeyToBytes; it needs its CRT parameters. The handle keeps the Montgomery setup of
+* p, q and n, and q^-1 mod p in Montgomery form.
+* Returns 0 if the key can not be imported; otherwise release the handle with ic_rsa_signer_close.
+*/
+IC_RSASigner* ic_rsa_signer_open(const unsigned char* key, unsigned int key_len);
+
+/*
+* Signs a SHA-512 hash with PKCS#1 v1.5, as RSACryptoServiceProvider.SignData does with SHA512.
+* The exponentiations mod p and mod q run on two threads when there is more than one core.
+* With LTC_RSA_BLINDING the message is blinded by r^e and the result unblinded by r^-1 mod n; the pair
+* is drawn at open and squared after each signature, rather than drawing and inverting a new r each
+* time. With LTC_RSA_CRT_HARDENING the signature is checked against the public key before it is returned.
+* sig_len holds the size of sig and receives the signature length.
+* Returns a CRYPT_* code. Safe to call from several threads with the same handle.
+*/
+int ic_rsa_sign(IC_RSASigner* signer, const unsigned char* hash, unsigned int hash_len, unsigned char* sig, unsigned long* sig_len);
+
+void ic_rsa_signer_close(IC_RSASigner* signer);
@@ -0,0 +1,269 @@
+#include "IC_RSAVerify.h"
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// tfm.h has no C++ guards of its own
+extern "C"
+{
+#include <tfm.h>
+}
+
+// DER DigestInfo of a SHA-512 hash, followed by the 64 hash bytes
+static const unsigned char ic_sha512_digest_info[] =
+{
+	0x30, 0x51, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x03, 0x05, 0x00, 0x04, 0x40
+};
+
+// A parsed public key with the Montgomery setup of its modulus
+struct IC_RSAPublicKey
+{
+	fp_int n;
+	fp_int e;
+	fp_int rr; // R^2 mod n
+	fp_digit mp;
+	unsigned long size; // bytes of n, and of every signature
+};
+
+typedef std::shared_ptr<const IC_RSAPublicKey> IC_RSAPublicKeyPtr;
+typedef std::list<std::pair<std::string, IC_RSAPublicKeyPtr>> IC_RSAKeyList;
+
+// Most recently used first; the index maps the SHA-512 of the key bytes to the list entry
+struct IC_RSAKeyCache
+{
+	std::mutex lock;
+	IC_RSAKeyList lru;
+	std::unordered_map<std::string, IC_RSAKeyList::iterator> index;
+};
+
+static IC_RSAKeyCache ic_rsa_key_cache;
+
+// Reads the little endian int32 length at offset, which has to fit the remaining bytes
+static bool ic_read_length(const unsigned char* bytes, unsigned int len, unsigned int* offset, unsigned int* value)
+{
+	if (len - *offset < 4)
+	{
+		return false;
+	}
+	const unsigned char* p = bytes + *offset;
+	unsigned long v = (unsigned long)p[0] | ((unsigned long)p[1] << 8) | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+	*offset += 4;
+	if (v > len - *offset)
+	{
+		return false;
+	}
+	*value = (unsigned int)v;
+	return true;
+}
+
+bool ic_rsa_key_fields(const unsigned char* key, unsigned int key_len, int count, const unsigned char** fields, unsigned int* lens)
+{
+	unsigned int offset = 0;
+	if (key_len != 523 && key_len != 2339)
+	{
+		offset = 5;
+		if (key_len < offset)
+		{
+			return false;
+		}
+	}
+	for (int i = 0; i < count; i++)
+	{
+		if (!ic_read_length(key, key_len, &offset, &lens[i]))
+		{
+			return false;
+		}
+		fields[i] = key + offset;
+		offset += lens[i];
+	}
+	return true;
+}
+
+void ic_rsa_encode_sha512(const unsigned char* hash, unsigned long size, unsigned char* em)
+{
+	unsigned long t_len = sizeof(ic_sha512_digest_info) + IC_SHA512_LEN;
+	memset(em, 0xFF, size);
+	em[0] = 0x00;
+	em[1] = 0x01;
+	em[size - t_len - 1] = 0x00;
+	memcpy(em + size - t_len, ic_sha512_digest_info, sizeof(ic_sha512_digest_info));
+	memcpy(em + size - IC_SHA512_LEN, hash, IC_SHA512_LEN);
+}
+
+// Parses an Ixian format public key; 0 if it is not one ic_rsa_verify takes (see IC_RSAVerify.h)
+static IC_RSAPublicKeyPtr ic_rsa_parse_key(const unsigned char* pubkey, unsigned int pubkey_len)
+{
+	const unsigned char* fields[2];
+	unsigned int lens[2];
+	if (!ic_rsa_key_fields(pubkey, pubkey_len, 2, fields, lens) || fields[1] + lens[1] != pubkey + pubkey_len)
+	{
+		return 0;
+	}
+	const unsigned char* n_bytes = fields[0];
+	const unsigned char* e_bytes = fields[1];
+	unsigned int n_len = lens[0], e_len = lens[1];
+
+	// fp_exptmod takes moduli of up to half of FP_MAX_SIZE
+	if (n_len > (FP_SIZE / 2) * (DIGIT_BIT / 8) || n_len < IC_RSA_MIN_SIZE || n_bytes[0] == 0 || (n_bytes[n_len - 1] & 1) == 0
+		|| e_len < 1 || e_len > 4 || e_bytes[0] == 0 || (e_bytes[e_len - 1] & 1) == 0 || (e_len == 1 && e_bytes[0] < 3))
+	{
+		return 0;
+	}
+
+	std::shared_ptr<IC_RSAPublicKey> key = std::make_shared<IC_RSAPublicKey>();
+	fp_init(&key->n);
+	fp_init(&key->e);
+	fp_init(&key->rr);
+	fp_read_unsigned_bin(&key->n, (unsigned char*)n_bytes, (int)n_len);
+	fp_read_unsigned_bin(&key->e, (unsigned char*)fields[1], (int)e_len);
+	if (fp_iszero(&key->e) || fp_montgomery_setup(&key->n, &key->mp) != FP_OKAY)
+	{
+		return 0;
+	}
+	fp_montgomery_calc_normalization(&key->rr, &key->n);
+	if (fp_sqrmod(&key->rr, &key->n, &key->rr) != FP_OKAY)
+	{
+		return 0;
+	}
+	key->size = n_len;
+	return key;
+}
+
+// The parsed key for pubkey, from the cache or parsed and added to it; 0 if ic_rsa_parse_key does not take it
+static IC_RSAPublicKeyPtr ic_rsa_get_key(const unsigned char* pubkey, unsigned int pubkey_len)
+{
+	unsigned char digest[IC_SHA512_LEN];
+	hash_state md;
+	sha512_init(&md);
+	sha512_process(&md, pubkey, pubkey_len);
+	sha512_done(&md, digest);
+	std::string id((const char*)digest, sizeof(digest));
+
+	IC_RSAKeyCache& cache = ic_rsa_key_cache;
+	{
+		std::lock_guard<std::mutex> guard(cache.lock);
+		auto it = cache.index.find(id);
+		if (it != cache.index.end())
+		{
+			cache.lru.splice(cache.lru.begin(), cache.lru, it->second);
+			return it->second->second;
+		}
+	}
+
+	// Parsed without the lock; another thread may have added the same key meanwhile
+	IC_RSAPublicKeyPtr key = ic_rsa_parse_key(pubkey, pubkey_len);
+	if (key == 0)
+	{
+		return 0;
+	}
+	std::lock_guard<std::mutex> guard(cache.lock);
+	if (cache.index.find(id) == cache.index.end())
+	{
+		cache.lru.emplace_front(id, key);
+		cache.index[id] = cache.lru.begin();
+		if (cache.lru.size() > IC_RSA_VERIFY_CACHE_SIZE)
+		{
+			cache.index.erase(cache.lru.back().first);
+			cache.lru.pop_back();
+		}
+	}
+	return key;
+}
+
+int ic_rsa_verify(const unsigned char* pubkey, unsigned int pubkey_len, const unsigned char* hash, unsigned int hash_len, const unsigned char* sig, unsigned int sig_len)
+{
+	if (pubkey == 0 || hash == 0 || sig == 0 || hash_len != IC_SHA512_LEN)
+	{
+		return 0;
+	}
+	IC_RSAPublicKeyPtr key = ic_rsa_get_key(pubkey, pubkey_len);
+	if (key == 0)
+	{
+		return IC_RSA_KEY_UNHANDLED;
+	}
+	if (sig_len != key->size)
+	{
+		return 0;
+	}
+
+	fp_int s, m;
+	fp_init(&s);
+	fp_init(&m);
+	fp_read_unsigned_bin(&s, (unsigned char*)sig, (int)sig_len);
+	if (fp_cmp(&s, (fp_int*)&key->n) != FP_LT
+		|| fp_exptmod_mont(&s, (fp_int*)&key->e, (fp_int*)&key->n, key->mp, (fp_int*)&key->rr, &m) != FP_OKAY)
+	{
+		return 0;
+	}
+
+	// The only valid encoding is the one of the hash, so build it and compare
+	std::vector<unsigned char> expected(key->size), decoded(key->size, 0);
+	ic_rsa_encode_sha512(hash, key->size, expected.data());
+
+	unsigned long m_len = (unsigned long)fp_unsigned_bin_size(&m);
+	fp_to_unsigned_bin(&m, decoded.data() + (key->size - m_len));
+	return memcmp(expected.data(), decoded.data(), key->size) == 0 ? 1 : 0;
+}
+
+int ic_rsa_verify_batch(const unsigned char* pubkeys, const unsigned int* pubkey_lens, const unsigned char* hashes, const unsigned char* sigs, const unsigned int* sig_lens, int count, int* results, unsigned int threads)
+{
+	if (pubkeys == 0 || pubkey_lens == 0 || hashes == 0 || sigs == 0 || sig_lens == 0 || results == 0 || count <= 0)
+	{
+		return 0;
+	}
+
+	// Where each item's key and signature start
+	std::vector<size_t> pubkey_offsets(count), sig_offsets(count);
+	size_t pubkey_offset = 0, sig_offset = 0;
+	for (int i = 0; i < count; i++)
+	{
+		pubkey_offsets[i] = pubkey_offset;
+		sig_offsets[i] = sig_offset;
+		pubkey_offset += pubkey_lens[i];
+		sig_offset += sig_lens[i];
+	}
+
+	std::atomic<int> next_index(0);
+	std::atomic<int> valid(0);
+	auto worker = [&]()
+	{
+		for (int i = next_index++; i < count; i = next_index++)
+		{
+			results[i] = ic_rsa_verify(pubkeys + pubkey_offsets[i], pubkey_lens[i], hashes + (size_t)IC_SHA512_LEN * i, IC_SHA512_LEN, sigs + sig_offsets[i], sig_lens[i]);
+			if (results[i] == 1)
+			{
+				valid++;
+			}
+		}
+	};
+
+	if (threads == 0)
+	{
+		threads = std::thread::hardware_concurrency();
+	}
+	if (threads == 0)
+	{
+		threads = 1;
+	}
+	if (threads > (unsigned int)count)
+	{
+		threads = (unsigned int)count;
+	}
+	std::vector<std::thread> pool;
+	for (unsigned int t = 1; t < threads; t++)
+	{
+		pool.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& t : pool)
+	{
+		t.join();
+	}
+	return valid;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <tomcrypt.h>
+
+// Public keys kept parsed by ic_rsa_verify, least recently used dropped first
+#define IC_RSA_VERIFY_CACHE_SIZE 1024
+
+#define IC_SHA512_LEN 64
+
+// ic_rsa_verify's result for a public key it leaves to the managed provider
+#define IC_RSA_KEY_UNHANDLED -1
+
+// The smallest modulus, in bytes, that holds a SHA-512 DigestInfo with PKCS#1 v1.5 padding
+#define IC_RSA_MIN_SIZE (11 + 19 + IC_SHA512_LEN)
+
+/*
+* Splits a key in the Ixian format of BouncyCastle.rsaKeyToBytes into its first count fields (modulus,
+* exponent, then P, Q, DP, DQ, InverseQ, D for private keys), skipping the version header the way
+* rsaKeyFromBytes does: keys of 523 and 2339 bytes have none, all others start with a 1 byte address
+* version and an int32 key version. Returns false if the key is too short.
+*/
+bool ic_rsa_key_fields(const unsigned char* key, unsigned int key_len, int count, const unsigned char** fields, unsigned int* lens);
+
+/*
+* Writes the PKCS#1 v1.5 block of a SHA-512 hash (00 01 FF .. FF 00 DigestInfo hash) to the size bytes
+* of em, size being at least IC_RSA_MIN_SIZE.
+*/
+void ic_rsa_encode_sha512(const unsigned char* hash, unsigned long size, unsigned char* em);
+
+/*
+* Verifies an RSA PKCS#1 v1.5 signature over a SHA-512 hash, as RSACryptoServiceProvider.VerifyData
+* does with SHA512. pubkey is in the Ixian format of BouncyCastle.rsaKeyToBytes, with or without
+* its version header. Only keys that rsaKeyFromBytes reads as exactly this modulus and exponent are
+* taken: the two fields end where the key does, with no private fields after them and no length
+* that Take would cut short, the modulus has no leading zero byte and is odd, and the exponent is
+* odd, at least 3 and of at most 4 bytes without a leading zero, as the CryptoAPI provider holds it.
+* For any other key the result is IC_RSA_KEY_UNHANDLED, and the caller has to verify with the
+* managed provider, so that a key is never judged differently with and without IXICrypt.
+* Parsed keys are cached by the SHA-512 of their bytes together with their Montgomery setup
+* (mp and R^2 mod N), so a repeated signer costs one fp_exptmod_mont and no division; for the
+* usual e = 65537 that is 16 squarings and two multiplies.
+* Returns 1 for a valid signature, 0 for an invalid one and IC_RSA_KEY_UNHANDLED as above. Safe to call
+* from several threads.
+*/
+int ic_rsa_verify(const unsigned char* pubkey, unsigned int pubkey_len, const unsigned char* hash, unsigned int hash_len, const unsigned char* sig, unsigned int sig_len);
+
+/*
+* ic_rsa_verify for count signatures, spread over threads workers (0 uses every core). The items are
+* packed one after another: item i has a public key of pubkey_lens[i] bytes in pubkeys, its 64 byte
+* hash at hashes + 64 * i and a signature of sig_lens[i] bytes in sigs. results[i] receives what
+* ic_rsa_verify returns for item i, which includes IC_RSA_KEY_UNHANDLED. Returns the number of valid signatures.
+*/
+int ic_rsa_verify_batch(const unsigned char* pubkeys, const unsigned int* pubkey_lens, const unsigned char* hashes, const unsigned char* sigs, const unsigned int* sig_lens, int count, int* results, unsigned int threads);
@@ -0,0 +1,152 @@
+#include "IC_SHA512.h"
+#include "IC_CPU.h"
+#include <tomcrypt.h>
+
+#ifdef IC_CPU_X86
+#include <immintrin.h>
+
+static const ulong64 ic_sha512_iv[8] =
+{
+	CONST64(0x6a09e667f3bcc908), CONST64(0xbb67ae8584caa73b),
+	CONST64(0x3c6ef372fe94f82b), CONST64(0xa54ff53a5f1d36f1),
+	CONST64(0x510e527fade682d1), CONST64(0x9b05688c2b3e6c1f),
+	CONST64(0x1f83d9abfb41bd6b), CONST64(0x5be0cd19137e2179)
+};
+
+static const ulong64 ic_sha512_k[80] =
+{
+	CONST64(0x428a2f98d728ae22), CONST64(0x7137449123ef65cd), CONST64(0xb5c0fbcfec4d3b2f), CONST64(0xe9b5dba58189dbbc),
+	CONST64(0x3956c25bf348b538), CONST64(0x59f111f1b605d019), CONST64(0x923f82a4af194f9b), CONST64(0xab1c5ed5da6d8118),
+	CONST64(0xd807aa98a3030242), CONST64(0x12835b0145706fbe), CONST64(0x243185be4ee4b28c), CONST64(0x550c7dc3d5ffb4e2),
+	CONST64(0x72be5d74f27b896f), CONST64(0x80deb1fe3b1696b1), CONST64(0x9bdc06a725c71235), CONST64(0xc19bf174cf692694),
+	CONST64(0xe49b69c19ef14ad2), CONST64(0xefbe4786384f25e3), CONST64(0x0fc19dc68b8cd5b5), CONST64(0x240ca1cc77ac9c65),
+	CONST64(0x2de92c6f592b0275), CONST64(0x4a7484aa6ea6e483), CONST64(0x5cb0a9dcbd41fbd4), CONST64(0x76f988da831153b5),
+	CONST64(0x983e5152ee66dfab), CONST64(0xa831c66d2db43210), CONST64(0xb00327c898fb213f), CONST64(0xbf597fc7beef0ee4),
+	CONST64(0xc6e00bf33da88fc2), CONST64(0xd5a79147930aa725), CONST64(0x06ca6351e003826f), CONST64(0x142929670a0e6e70),
+	CONST64(0x27b70a8546d22ffc), CONST64(0x2e1b21385c26c926), CONST64(0x4d2c6dfc5ac42aed), CONST64(0x53380d139d95b3df),
+	CONST64(0x650a73548baf63de), CONST64(0x766a0abb3c77b2a8), CONST64(0x81c2c92e47edaee6), CONST64(0x92722c851482353b),
+	CONST64(0xa2bfe8a14cf10364), CONST64(0xa81a664bbc423001), CONST64(0xc24b8b70d0f89791), CONST64(0xc76c51a30654be30),
+	CONST64(0xd192e819d6ef5218), CONST64(0xd69906245565a910), CONST64(0xf40e35855771202a), CONST64(0x106aa07032bbd1b8),
+	CONST64(0x19a4c116b8d2d0c8), CONST64(0x1e376c085141ab53), CONST64(0x2748774cdf8eeb99), CONST64(0x34b0bcb5e19b48a8),
+	CONST64(0x391c0cb3c5c95a63), CONST64(0x4ed8aa4ae3418acb), CONST64(0x5b9cca4f7763e373), CONST64(0x682e6ff3d6b2b8a3),
+	CONST64(0x748f82ee5defb2fc), CONST64(0x78a5636f43172f60), CONST64(0x84c87814a1f0ab72), CONST64(0x8cc702081a6439ec),
+	CONST64(0x90befffa23631e28), CONST64(0xa4506cebde82bde9), CONST64(0xbef9a3f7b2c67915), CONST64(0xc67178f2e372532b),
+	CONST64(0xca273eceea26619c), CONST64(0xd186b8c721c0c207), CONST64(0xeada7dd6cde0eb1e), CONST64(0xf57d4f7fee6ed178),
+	CONST64(0x06f067aa72176fba), CONST64(0x0a637dc5a2c898a6), CONST64(0x113f9804bef90dae), CONST64(0x1b710b35131c471b),
+	CONST64(0x28db77f523047d84), CONST64(0x32caab7b40c72493), CONST64(0x3c9ebe0a15c9bebc), CONST64(0x431d67c49c100d4c),
+	CONST64(0x4cc5d4becb3e42b6), CONST64(0x597f299cfc657e2a), CONST64(0x5fcb6fab3ad6faec), CONST64(0x6c44198c4a475817)
+};
+
+// Each kernel is compiled for its own instruction set and only called once
+// ic_cpu_features reports it, so the library still loads on older CPUs.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#define IC_SHA512_LANES		4
+#define IC_SHA512_TWIDDLE	ic_sha512_twiddle_avx2
+#define V					__m256i
+#define V_SET1(x)			_mm256_set1_epi64x((long long)(x))
+#define V_LOADU(p)			_mm256_loadu_si256((const __m256i*)(p))
+#define V_STOREU(p, x)		_mm256_storeu_si256((__m256i*)(p), x)
+#define V_ADD(x, y)			_mm256_add_epi64(x, y)
+#define V_XOR3(x, y, z)		_mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#define V_SHR(x, n)			_mm256_srli_epi64(x, n)
+#define V_ROR(x, n)			_mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - (n)))
+#define V_CH(x, y, z)		_mm256_xor_si256(_mm256_and_si256(x, y), _mm256_andnot_si256(x, z))
+#define V_MAJ(x, y, z)		_mm256_or_si256(_mm256_and_si256(x, y), _mm256_and_si256(z, _mm256_or_si256(x, y)))
+#include "IC_SHA512_lanes.inl"
+#undef IC_SHA512_LANES
+#undef IC_SHA512_TWIDDLE
+#undef V
+#undef V_SET1
+#undef V_LOADU
+#undef V_STOREU
+#undef V_ADD
+#undef V_XOR3
+#undef V_SHR
+#undef V_ROR
+#undef V_CH
+#undef V_MAJ
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+// Ternary logic immediates: 0x96 = x ^ y ^ z, 0xCA = x ? y : z, 0xE8 = majority
+#define IC_SHA512_LANES		8
+#define IC_SHA512_TWIDDLE	ic_sha512_twiddle_avx512
+#define V					__m512i
+#define V_SET1(x)			_mm512_set1_epi64((long long)(x))
+#define V_LOADU(p)			_mm512_loadu_si512((const void*)(p))
+#define V_STOREU(p, x)		_mm512_storeu_si512((void*)(p), x)
+#define V_ADD(x, y)			_mm512_add_epi64(x, y)
+#define V_XOR3(x, y, z)		_mm512_ternarylogic_epi64(x, y, z, 0x96)
+#define V_SHR(x, n)			_mm512_srli_epi64(x, n)
+#define V_ROR(x, n)			_mm512_ror_epi64(x, n)
+#define V_CH(x, y, z)		_mm512_ternarylogic_epi64(x, y, z, 0xCA)
+#define V_MAJ(x, y, z)		_mm512_ternarylogic_epi64(x, y, z, 0xE8)
+#include "IC_SHA512_lanes.inl"
+#undef IC_SHA512_LANES
+#undef IC_SHA512_TWIDDLE
+#undef V
+#undef V_SET1
+#undef V_LOADU
+#undef V_STOREU
+#undef V_ADD
+#undef V_XOR3
+#undef V_SHR
+#undef V_ROR
+#undef V_CH
+#undef V_MAJ
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
+
+void ic_sha512_twiddle(unsigned char* state, unsigned int state_len, unsigned int iterations)
+{
+	unsigned int blocks = state_len / 64;
+	unsigned int i = 0;
+
+#ifdef IC_CPU_X86
+	unsigned int features = ic_cpu_features();
+	if (features & IC_CPU_AVX512F)
+	{
+		for (; i + 8 <= blocks; i += 8)
+		{
+			ic_sha512_twiddle_avx512(state + i * 64, iterations);
+		}
+	}
+	if (features & IC_CPU_AVX2)
+	{
+		for (; i + 4 <= blocks; i += 4)
+		{
+			ic_sha512_twiddle_avx2(state + i * 64, iterations);
+		}
+	}
+#endif
+
+	// Whatever is left, one block at a time
+	hash_state md;
+	for (; i < blocks; i++)
+	{
+		for (unsigned int it = 0; it < iterations; it++)
+		{
+			sha512_desc.init(&md);
+			sha512_desc.process(&md, state + i * 64, 64);
+			sha512_desc.done(&md, state + i * 64);
+		}
+	}
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+/*
+* Replaces every 64-byte block of state (state_len / 64 of them; a shorter tail is left alone)
+* by its SHA-512, iterations times. The blocks are independent, so they are hashed several at
+* a time with AVX2 (4 blocks) or AVX-512 (8 blocks) when the CPU has them, and through
+* sha512_desc otherwise; the result is the same either way.
+*/
+void ic_sha512_twiddle(unsigned char* state, unsigned int state_len, unsigned int iterations);
@@ -0,0 +1,85 @@
+// Multi-buffer SHA-512 of 64-byte messages, one message per vector lane.
+// Included by IC_SHA512.cpp once per instruction set, with these defined:
+//   IC_SHA512_LANES	messages hashed together
+//   IC_SHA512_TWIDDLE	name of the function to define
+//   V					vector of IC_SHA512_LANES 64-bit words
+//   V_SET1, V_LOADU, V_STOREU, V_ADD, V_XOR3, V_SHR, V_ROR, V_CH, V_MAJ
+
+// A 64-byte message is a single padded block: the message, 0x80, zeros and the
+// bit length 512. Each iteration hashes the previous digest, so the words stay
+// in registers between iterations and are only converted from and to big
+// endian at the ends.
+static void IC_SHA512_TWIDDLE(unsigned char* blocks, unsigned int iterations)
+{
+	ulong64 lanes[IC_SHA512_LANES];
+	V m[8];
+
+	for (int i = 0; i < 8; i++)
+	{
+		for (int l = 0; l < IC_SHA512_LANES; l++)
+		{
+			LOAD64H(lanes[l], blocks + l * 64 + i * 8);
+		}
+		m[i] = V_LOADU(lanes);
+	}
+
+	for (unsigned int it = 0; it < iterations; it++)
+	{
+		V w[16];
+		for (int i = 0; i < 8; i++)
+		{
+			w[i] = m[i];
+		}
+		w[8] = V_SET1(CONST64(0x8000000000000000));
+		for (int i = 9; i < 15; i++)
+		{
+			w[i] = V_SET1(0);
+		}
+		w[15] = V_SET1(512);
+
+		V a = V_SET1(ic_sha512_iv[0]), b = V_SET1(ic_sha512_iv[1]);
+		V c = V_SET1(ic_sha512_iv[2]), d = V_SET1(ic_sha512_iv[3]);
+		V e = V_SET1(ic_sha512_iv[4]), f = V_SET1(ic_sha512_iv[5]);
+		V g = V_SET1(ic_sha512_iv[6]), h = V_SET1(ic_sha512_iv[7]);
+
+		for (int t = 0; t < 80; t++)
+		{
+			if (t >= 16)
+			{
+				V w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+				V s0 = V_XOR3(V_ROR(w15, 1), V_ROR(w15, 8), V_SHR(w15, 7));
+				V s1 = V_XOR3(V_ROR(w2, 19), V_ROR(w2, 61), V_SHR(w2, 6));
+				w[t & 15] = V_ADD(V_ADD(w[t & 15], s0), V_ADD(w[(t - 7) & 15], s1));
+			}
+			V t1 = V_ADD(V_ADD(h, V_XOR3(V_ROR(e, 14), V_ROR(e, 18), V_ROR(e, 41))),
+				V_ADD(V_CH(e, f, g), V_ADD(V_SET1(ic_sha512_k[t]), w[t & 15])));
+			V t2 = V_ADD(V_XOR3(V_ROR(a, 28), V_ROR(a, 34), V_ROR(a, 39)), V_MAJ(a, b, c));
+			h = g;
+			g = f;
+			f = e;
+			e = V_ADD(d, t1);
+			d = c;
+			c = b;
+			b = a;
+			a = V_ADD(t1, t2);
+		}
+
+		m[0] = V_ADD(a, V_SET1(ic_sha512_iv[0]));
+		m[1] = V_ADD(b, V_SET1(ic_sha512_iv[1]));
+		m[2] = V_ADD(c, V_SET1(ic_sha512_iv[2]));
+		m[3] = V_ADD(d, V_SET1(ic_sha512_iv[3]));
+		m[4] = V_ADD(e, V_SET1(ic_sha512_iv[4]));
+		m[5] = V_ADD(f, V_SET1(ic_sha512_iv[5]));
+		m[6] = V_ADD(g, V_SET1(ic_sha512_iv[6]));
+		m[7] = V_ADD(h, V_SET1(ic_sha512_iv[7]));
+	}
+
+	for (int i = 0; i < 8; i++)
+	{
+		V_STOREU(lanes, m[i]);
+		for (int l = 0; l < IC_SHA512_LANES; l++)
+		{
+			STORE64H(lanes[l], blocks + l * 64 + i * 8);
+		}
+	}
+}
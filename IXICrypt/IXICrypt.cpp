@@ -1,6 +1,18 @@
+#include "IC_AES.h"
+#include "IC_ChaCha.h"
+#include "IC_GCM.h"
+#include "IC_Poly1305.h"
 #include "IC_PRNG.h"
+#include "IC_RSAKeyGen.h"
+#include "IC_RSASign.h"
+#include "IC_RSAVerify.h"
+#include "IC_SHA512.h"
 #include "IXICrypt.h"
 #include <tfm.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 unsigned long ix_prng_read(unsigned char* out, unsigned long outlen, prng_state *prng);
 const struct ltc_prng_descriptor ixiprng_desc = 
@@ -23,55 +35,194 @@ unsigned long ix_prng_read(unsigned char* out, unsigned long outlen, prng_state
 	return outlen;
 }
 
-IXI_RSA_KEY* ix_generate_rsa(unsigned char* entropy, unsigned int entropy_len, int key_size_bits, unsigned long pub_exponent)
+// Registers everything once, as native calls may come from several threads at a time
+static void ix_register_primitives()
 {
-	//printf("Generating RSA key: entropy (%d bytes), key bits: %d, exponent: %d.\n", entropy_len, key_size_bits, pub_exponent);
-	//printf("Preparing PRNG...\n");
-	// register required primitives
-	if (find_prng("ixiprng") == -1)
+	static std::once_flag registered;
+	std::call_once(registered, []()
 	{
-		register_prng(&ixiprng_desc);
-		register_prng(&sprng_desc);
-	}
-	if (find_hash("sha512") == -1)
-	{
-		register_hash(&sha512_desc);
-	}
-	if (find_cipher("aes") == -1)
-	{
-		register_cipher(&aes_desc);
-	}
+		if (find_prng("ixiprng") == -1)
+		{
+			register_prng(&ixiprng_desc);
+			register_prng(&sprng_desc);
+		}
+		if (find_hash("sha512") == -1)
+		{
+			register_hash(&sha512_desc);
+		}
+		if (find_cipher("aes") == -1)
+		{
+			register_cipher(ic_aes_desc());
+		}
+		ltc_mp = tfm_desc;
+		ltc_gcm_accel = ic_gcm_accel();
+		ltc_chacha_accel = ic_chacha_accel();
+		ltc_poly1305_accel = ic_poly1305_accel();
+	});
+}
+
+// Exports a generated key as PKCS#1 and frees it
+static IXI_RSA_KEY* ix_export_rsa_key(Rsa_key* tc_key)
+{
+	IXI_RSA_KEY *export_ixikey = new IXI_RSA_KEY();
+	unsigned char pkcs1_export[65536];
+	unsigned long export_len = 65536;
+	//printf("Exporting from libtomcrypt into PKCS#1...\n");
+	rsa_export(pkcs1_export, &export_len, PK_PRIVATE, tc_key);
+	//printf("Export blobl len: %d.\n", export_len);
+	export_ixikey->len = (unsigned int)export_len;
+	export_ixikey->bytes = new unsigned char[export_ixikey->len];
+	memcpy(export_ixikey->bytes, pkcs1_export, export_ixikey->len);
+	rsa_free(tc_key);
+	//printf("Done, returning... exported address: %p\n", export_ixikey);
+	return export_ixikey;
+}
+
+// Generates one key once ix_register_primitives has run; safe to call from several threads
+static IXI_RSA_KEY* ix_make_rsa_key(unsigned char* entropy, unsigned int entropy_len, int key_size_bits, unsigned long pub_exponent)
+{
 	IC_PRNG prng;
 	prng.setEntropy(entropy, entropy_len);
 	Rsa_key tc_key;
 	//printf("Calling libtomcrypt make key...\n");
-	ltc_mp = tfm_desc;
 	int result = rsa_make_key((prng_state*)&prng, find_prng("ixiprng"), key_size_bits / 8, (long)pub_exponent, &tc_key);
 	//int result = rsa_make_key(NULL, find_prng("sprng"), key_size_bits / 8, (long)pub_exponent, &tc_key);
 	//printf("Result: %d\n", result);
 	if (result == CRYPT_OK)
 	{
-		IXI_RSA_KEY *export_ixikey = new IXI_RSA_KEY();
-		unsigned char pkcs1_export[65536];
-		unsigned long export_len = 65536;
-		//printf("Exporting from libtomcrypt into PKCS#1...\n");
-		rsa_export(pkcs1_export, &export_len, PK_PRIVATE, &tc_key);
-		//printf("Export blobl len: %d.\n", export_len);
-		export_ixikey->len = (unsigned int)export_len;
-		export_ixikey->bytes = new unsigned char[export_ixikey->len];
-		memcpy(export_ixikey->bytes, pkcs1_export, export_ixikey->len);
-		rsa_free(&tc_key);
-		//printf("Done, returning... exported address: %p\n", export_ixikey);
-		return export_ixikey;
+		return ix_export_rsa_key(&tc_key);
 	}
 	return 0;
 }
 
+void ix_twiddle_state(unsigned char* state, unsigned int state_len, unsigned int iterations)
+{
+	ic_sha512_twiddle(state, state_len, iterations);
+}
+
+IXI_RSA_KEY* ix_generate_rsa(unsigned char* entropy, unsigned int entropy_len, int key_size_bits, unsigned long pub_exponent)
+{
+	//printf("Generating RSA key: entropy (%d bytes), key bits: %d, exponent: %d.\n", entropy_len, key_size_bits, pub_exponent);
+	//printf("Preparing PRNG...\n");
+	// register required primitives
+	ix_register_primitives();
+	return ix_make_rsa_key(entropy, entropy_len, key_size_bits, pub_exponent);
+}
+
+IXI_RSA_KEY* ix_generate_rsa_v2(unsigned char* entropy, unsigned int entropy_len, int key_size_bits, unsigned long pub_exponent)
+{
+	ix_register_primitives();
+	Rsa_key tc_key;
+	if (ic_rsa_make_key_v2(entropy, entropy_len, key_size_bits / 8, (long)pub_exponent, &tc_key, 0) == CRYPT_OK)
+	{
+		return ix_export_rsa_key(&tc_key);
+	}
+	return 0;
+}
+
+int ix_generate_rsa_many(unsigned char* entropy, unsigned int entropy_len, int first_index, int count, int key_size_bits, unsigned long pub_exponent, IXI_RSA_KEY** out_keys)
+{
+	if (entropy == 0 || out_keys == 0 || entropy_len == 0 || entropy_len % 64 != 0 || first_index < 0 || count <= 0)
+	{
+		return 0;
+	}
+	ix_register_primitives();
+
+	// The pool for the next unclaimed index; workers take a copy and advance it by one twiddle
+	std::vector<unsigned char> state(entropy, entropy + entropy_len);
+	ix_twiddle_state(state.data(), entropy_len, (unsigned int)first_index);
+	int next_index = 0;
+	std::mutex state_lock;
+	std::atomic<int> generated(0);
+
+	auto worker = [&]()
+	{
+		std::vector<unsigned char> key_entropy(entropy_len);
+		for (;;)
+		{
+			int i;
+			{
+				std::lock_guard<std::mutex> guard(state_lock);
+				if (next_index >= count)
+				{
+					break;
+				}
+				i = next_index++;
+				memcpy(key_entropy.data(), state.data(), entropy_len);
+				if (next_index < count)
+				{
+					ix_twiddle_state(state.data(), entropy_len, 1);
+				}
+			}
+			out_keys[i] = ix_make_rsa_key(key_entropy.data(), entropy_len, key_size_bits, pub_exponent);
+			if (out_keys[i] != 0)
+			{
+				generated++;
+			}
+		}
+		zeromem(key_entropy.data(), entropy_len);
+	};
+
+	unsigned int threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+	{
+		threads = 1;
+	}
+	if (threads > (unsigned int)count)
+	{
+		threads = (unsigned int)count;
+	}
+	std::vector<std::thread> pool;
+	for (unsigned int t = 1; t < threads; t++)
+	{
+		pool.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& t : pool)
+	{
+		t.join();
+	}
+	zeromem(state.data(), entropy_len);
+	return generated;
+}
+
+int ix_rsa_verify(unsigned char* pubkey, unsigned int pubkey_len, unsigned char* msg_hash, unsigned int hash_len, unsigned char* sig, unsigned int sig_len)
+{
+	return ic_rsa_verify(pubkey, pubkey_len, msg_hash, hash_len, sig, sig_len);
+}
+
+int ix_rsa_verify_batch(unsigned char* pubkeys, unsigned int* pubkey_lens, unsigned char* msg_hashes, unsigned char* sigs, unsigned int* sig_lens, int count, int* results)
+{
+	return ic_rsa_verify_batch(pubkeys, pubkey_lens, msg_hashes, sigs, sig_lens, count, results, 0);
+}
+
+IC_RSASigner* ix_rsa_signer_open(unsigned char* key, unsigned int key_len)
+{
+	ix_register_primitives();
+	return ic_rsa_signer_open(key, key_len);
+}
+
+int ix_rsa_sign(IC_RSASigner* signer, unsigned char* msg_hash, unsigned int hash_len, unsigned char* sig, unsigned int sig_len)
+{
+	unsigned long len = sig_len;
+	if (ic_rsa_sign(signer, msg_hash, hash_len, sig, &len) != CRYPT_OK)
+	{
+		return 0;
+	}
+	return (int)len;
+}
+
+void ix_rsa_signer_close(IC_RSASigner* signer)
+{
+	ic_rsa_signer_close(signer);
+}
+
 void ix_free_key(IXI_RSA_KEY* key)
 {
 	//printf("Called Free on RSA exported structure: %p\n", key);
 	if (key != 0) 
 	{
+		delete[] key->bytes;
 		delete key;
 	}
 }
\ No newline at end of file
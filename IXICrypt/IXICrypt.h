@@ -10,8 +10,37 @@ struct IXI_RSA_KEY
 	unsigned char* bytes;
 };
 
+struct IC_RSASigner;
+
 extern "C"
 {
 	IXI_EXPORT IXI_RSA_KEY* ix_generate_rsa(unsigned char* entropy, unsigned int entropy_len, int key_size_bits, unsigned long pub_exponent);
+	// Key generation version 2: a different key from the same entropy, found about twice as fast on several
+	// cores by searching for both primes at once (see ic_rsa_make_key_v2). Keys derived with ix_generate_rsa
+	// are unaffected; the version a key was derived with has to be kept to derive it again.
+	IXI_EXPORT IXI_RSA_KEY* ix_generate_rsa_v2(unsigned char* entropy, unsigned int entropy_len, int key_size_bits, unsigned long pub_exponent);
+	// Derives the keys for key indexes first_index .. first_index + count - 1 from the untwiddled entropy pool,
+	// as ix_generate_rsa would for each index's pool, spread over all cores. out_keys[i] receives the key for
+	// first_index + i (0 if it failed), to be freed with ix_free_key. Returns the number of keys generated.
+	IXI_EXPORT int ix_generate_rsa_many(unsigned char* entropy, unsigned int entropy_len, int first_index, int count, int key_size_bits, unsigned long pub_exponent, IXI_RSA_KEY** out_keys);
+	// Replaces every 64-byte block of state by its SHA-512, iterations times; the same as that many
+	// KeyDerivation.PRNG.twiddleRandomState calls on the C# side
+	IXI_EXPORT void ix_twiddle_state(unsigned char* state, unsigned int state_len, unsigned int iterations);
+	// Verifies a signature of the SHA-512 hash msg_hash (hash_len 64) with an Ixian format public key, as
+	// CryptoLib.verifySignature does for the hashed data. Returns 1 if it is valid, 0 if not, and -1 for a key
+	// that has to be verified with the managed provider instead (see ic_rsa_verify). Recently used keys are
+	// kept parsed, so a repeated signer is not parsed again.
+	IXI_EXPORT int ix_rsa_verify(unsigned char* pubkey, unsigned int pubkey_len, unsigned char* msg_hash, unsigned int hash_len, unsigned char* sig, unsigned int sig_len);
+	// ix_rsa_verify for count signatures on all cores. Items are packed one after another: pubkey_lens[i] bytes
+	// of pubkeys, 64 bytes of msg_hashes and sig_lens[i] bytes of sigs each. results[i] is what ix_rsa_verify
+	// returns for item i. Returns the number of valid signatures.
+	IXI_EXPORT int ix_rsa_verify_batch(unsigned char* pubkeys, unsigned int* pubkey_lens, unsigned char* msg_hashes, unsigned char* sigs, unsigned int* sig_lens, int count, int* results);
+	// Imports a private key once for signing: the PKCS#1 blob of ix_generate_rsa or an Ixian format private key
+	// (see ic_rsa_signer_open). Returns 0 if the key is invalid; the handle is released with ix_rsa_signer_close.
+	IXI_EXPORT IC_RSASigner* ix_rsa_signer_open(unsigned char* key, unsigned int key_len);
+	// Signs the SHA-512 hash msg_hash (hash_len 64) into the sig_len bytes of sig, as CryptoLib.getSignature does
+	// for the hashed data. Returns the length of the signature, 0 if signing failed or sig is too small.
+	IXI_EXPORT int ix_rsa_sign(IC_RSASigner* signer, unsigned char* msg_hash, unsigned int hash_len, unsigned char* sig, unsigned int sig_len);
+	IXI_EXPORT void ix_rsa_signer_close(IC_RSASigner* signer);
 	IXI_EXPORT void ix_free_key(IXI_RSA_KEY* key);
 }
@@ -15,6 +15,9 @@
 
 #ifdef LTC_GCM_MODE
 
+/* The GHASH accelerator gcm_init hands to new states, NULL for none */
+const ltc_gcm_accel_descriptor *ltc_gcm_accel = NULL;
+
 /**
   Initialize a GCM state
   @param gcm     The GCM state to initialize
@@ -69,6 +72,18 @@ int gcm_init(gcm_state *gcm, int cipher,
    gcm->buflen   = 0;
    gcm->totlen   = 0;
    gcm->pttotlen = 0;
+   gcm->accel    = NULL;
+
+   /* an accelerator has its own form of H and no need of the tables */
+   if (ltc_gcm_accel != NULL) {
+      if ((err = ltc_gcm_accel->init(gcm)) == CRYPT_OK) {
+         gcm->accel = ltc_gcm_accel;
+         return CRYPT_OK;
+      }
+      if (err != CRYPT_NOP) {
+         return err;
+      }
+   }
 
 #ifdef LTC_GCM_TABLES
    /* setup tables */
@@ -24,6 +24,14 @@ void gcm_mult_h(const gcm_state *gcm, unsigned char *I)
    unsigned char T[16];
 #ifdef LTC_GCM_TABLES
    int x;
+#endif
+
+   if (gcm->accel != NULL) {
+      gcm->accel->mult_h(gcm, I);
+      return;
+   }
+
+#ifdef LTC_GCM_TABLES
 #ifdef LTC_GCM_TABLES_SSE2
    asm("movdqa (%0),%%xmm0"::"r"(&gcm->PC[0][I[0]][0]));
    for (x = 1; x < 16; x++) {
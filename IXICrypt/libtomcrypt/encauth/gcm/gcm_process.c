@@ -83,10 +83,18 @@ int gcm_process(gcm_state *gcm,
    }
 
    x = 0;
+   /* whole blocks through the accelerator, if it takes this cipher */
+   if ((gcm->buflen == 0) && (ptlen >= 16) && (gcm->accel != NULL) && (gcm->accel->process != NULL)) {
+      if ((err = gcm->accel->process(gcm, pt, ct, ptlen / 16, direction)) == CRYPT_OK) {
+         x = ptlen & ~15;
+      } else if (err != CRYPT_NOP) {
+         return err;
+      }
+   }
 #ifdef LTC_FAST
    if (gcm->buflen == 0) {
       if (direction == GCM_ENCRYPT) {
-         for (x = 0; x < (ptlen & ~15); x += 16) {
+         for (; x < (ptlen & ~15); x += 16) {
              /* ctr encrypt */
              for (y = 0; y < 16; y += sizeof(LTC_FAST_TYPE)) {
                  *(LTC_FAST_TYPE_PTR_CAST(&ct[x + y])) = *(LTC_FAST_TYPE_PTR_CAST(&pt[x+y])) ^ *(LTC_FAST_TYPE_PTR_CAST(&gcm->buf[y]));
@@ -104,7 +112,7 @@ int gcm_process(gcm_state *gcm,
              }
          }
       } else {
-         for (x = 0; x < (ptlen & ~15); x += 16) {
+         for (; x < (ptlen & ~15); x += 16) {
              /* ctr encrypt */
              for (y = 0; y < 16; y += sizeof(LTC_FAST_TYPE)) {
                  *(LTC_FAST_TYPE_PTR_CAST(&gcm->X[y])) ^= *(LTC_FAST_TYPE_PTR_CAST(&ct[x+y]));
@@ -1002,6 +1002,25 @@ typedef struct {
    int rounds;
 } chacha_state;
 
+/** An optional multi-block ChaCha kernel, e.g. on SIMD instructions. chacha_crypt hands the
+    one in ltc_chacha_accel the whole blocks of its input. */
+typedef struct ltc_chacha_accel_descriptor {
+   /** Name of the kernel */
+   const char *name;
+
+   /** XOR blocks of key stream into the input, as chacha_crypt would one block at a time
+       @param input   The ChaCha state words; block i uses input[12] + i as its counter word,
+                      which the caller keeps from wrapping, and input is not updated
+       @param rounds  Number of rounds
+       @param in      The plaintext (or ciphertext)
+       @param out     [out] The ciphertext (or plaintext), may be in
+       @param blocks  The number of 64 byte blocks
+   */
+   void (*crypt)(const ulong32 *input, int rounds, const unsigned char *in, unsigned char *out, unsigned long blocks);
+} ltc_chacha_accel_descriptor;
+
+extern const ltc_chacha_accel_descriptor *ltc_chacha_accel;
+
 int chacha_setup(chacha_state *st, const unsigned char *key, unsigned long keylen, int rounds);
 int chacha_ivctr32(chacha_state *st, const unsigned char *iv, unsigned long ivlen, ulong32 counter);
 int chacha_ivctr64(chacha_state *st, const unsigned char *iv, unsigned long ivlen, ulong64 counter);
@@ -115,6 +115,22 @@ typedef struct {
    int final;
 } poly1305_state;
 
+/** An optional Poly1305 kernel, e.g. on 64-bit multiplies or SIMD instructions. poly1305_process
+    hands the one in ltc_poly1305_accel the whole blocks of its input. */
+typedef struct ltc_poly1305_accel_descriptor {
+   /** Name of the kernel */
+   const char *name;
+
+   /** Absorb whole blocks of message, as the 16 byte blocks of poly1305_process
+       @param st      The POLY1305 state, with st->h left carried as the built-in code leaves it
+       @param in      The data
+       @param inlen   The length of the data, a multiple of 16 (octets)
+   */
+   void (*blocks)(poly1305_state *st, const unsigned char *in, unsigned long inlen);
+} ltc_poly1305_accel_descriptor;
+
+extern const ltc_poly1305_accel_descriptor *ltc_poly1305_accel;
+
 int poly1305_init(poly1305_state *st, const unsigned char *key, unsigned long keylen);
 int poly1305_process(poly1305_state *st, const unsigned char *in, unsigned long inlen);
 int poly1305_done(poly1305_state *st, unsigned char *mac, unsigned long *maclen);
@@ -470,6 +486,8 @@ extern const unsigned char gcm_shift_table[];
 #define LTC_GCM_MODE_AAD   1
 #define LTC_GCM_MODE_TEXT  2
 
+struct ltc_gcm_accel_descriptor;
+
 typedef struct {
    symmetric_key       K;
    unsigned char       H[16],        /* multiplier */
@@ -486,6 +504,9 @@ typedef struct {
    ulong64             totlen,       /* 64-bit counter used for IV and AAD */
                        pttotlen;     /* 64-bit counter for the PT */
 
+   const struct ltc_gcm_accel_descriptor *accel; /* GHASH accelerator, NULL for the tables */
+   unsigned char       HP[4][16];    /* H^1..H^4 in the accelerator's format */
+
 #ifdef LTC_GCM_TABLES
    unsigned char       PC[16][256][16]  /* 16 tables of 8x128 */
 #ifdef LTC_GCM_TABLES_SSE2
@@ -495,6 +516,37 @@ __attribute__ ((aligned (16)))
 #endif
 } gcm_state;
 
+/** An optional GHASH accelerator, e.g. on carry-less multiply instructions. gcm_init takes the
+    one in ltc_gcm_accel, if any, instead of building the tables. */
+typedef struct ltc_gcm_accel_descriptor {
+   /** Name of the accelerator */
+   const char *name;
+
+   /** Prepare gcm->HP from gcm->H
+       @param gcm     The GCM state
+       @return CRYPT_OK if successful, CRYPT_NOP to leave the state to the tables
+   */
+   int (*init)(gcm_state *gcm);
+
+   /** Multiply by H, as gcm_mult_h
+       @param gcm     The GCM state
+       @param I       The value to multiply H by
+   */
+   void (*mult_h)(const gcm_state *gcm, unsigned char *I);
+
+   /** Process whole blocks of text with an empty buf, as gcm_process would
+       @param gcm        The GCM state
+       @param pt         The plaintext
+       @param ct         The ciphertext
+       @param blocks     The number of 16 byte blocks
+       @param direction  GCM_ENCRYPT or GCM_DECRYPT
+       @return CRYPT_OK if successful, CRYPT_NOP to leave the blocks to gcm_process (e.g. for a cipher it has no kernel for)
+   */
+   int (*process)(gcm_state *gcm, unsigned char *pt, unsigned char *ct, unsigned long blocks, int direction);
+} ltc_gcm_accel_descriptor;
+
+extern const ltc_gcm_accel_descriptor *ltc_gcm_accel;
+
 void gcm_mult_h(const gcm_state *gcm, unsigned char *I);
 
 int gcm_init(gcm_state *gcm, int cipher,
@@ -24,6 +24,9 @@ enum public_key_type {
 };
 
 int rand_prime(void *N, long len, prng_state *prng, int wprng);
+int rand_prime_tester_init(void **tester, long len);
+int rand_prime_test(void *tester, unsigned char *buf, void *N, int *res);
+void rand_prime_tester_done(void *tester);
 
 /* ---- RSA ---- */
 #ifdef LTC_MRSA
@@ -51,6 +54,7 @@ typedef struct Rsa_key {
 } rsa_key;
 
 int rsa_make_key(prng_state *prng, int wprng, int size, long e, rsa_key *key);
+int rsa_make_key_from_primes(void *p, void *q, long e, rsa_key *key);
 
 int rsa_get_size(const rsa_key *key);
 
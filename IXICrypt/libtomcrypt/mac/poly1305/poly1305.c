@@ -16,6 +16,8 @@
 
 #ifdef LTC_POLY1305
 
+const ltc_poly1305_accel_descriptor *ltc_poly1305_accel = NULL;
+
 /* internal only */
 static void _poly1305_block(poly1305_state *st, const unsigned char *in, unsigned long inlen)
 {
@@ -148,7 +150,11 @@ int poly1305_process(poly1305_state *st, const unsigned char *in, unsigned long
    /* process full blocks */
    if (inlen >= 16) {
       unsigned long want = (inlen & ~(16 - 1));
-      _poly1305_block(st, in, want);
+      if (ltc_poly1305_accel != NULL) {
+         ltc_poly1305_accel->blocks(st, in, want);
+      } else {
+         _poly1305_block(st, in, want);
+      }
       in += want;
       inlen -= want;
    }
@@ -17,25 +17,214 @@
 
 #define USE_BBS 1
 
-int rand_prime(void *N, long len, prng_state *prng, int wprng)
+/* Odd primes below this are divided out of every candidate before it is
+ * handed to mp_prime_is_prime */
+#ifndef LTC_RAND_PRIME_SIEVE_LIMIT
+   #define LTC_RAND_PRIME_SIEVE_LIMIT 16384
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+   #include <intrin.h>
+#endif
+
+/* consecutive sieve primes whose product fits in 32 bits */
+typedef struct {
+   ulong64 mu;          /* floor(2^64 / m), the Barrett reciprocal */
+   ulong32 m;           /* product of the primes */
+   int     first, count;
+} sieve_group;
+
+typedef struct {
+   unsigned short *primes;
+   sieve_group    *groups;
+   int             ngroups;  /* a multiple of 4, padded with empty groups */
+   ulong32        *words;    /* the candidate as 32-bit words, most significant first */
+   long            len;      /* candidate size in octets */
+   int             type;     /* USE_BBS or 0 */
+} prime_sieve;
+
+/* high 64 bits of a * b */
+static LTC_INLINE ulong64 s_mulhi(ulong64 a, ulong64 b)
 {
-   int            err, res, type;
-   unsigned char *buf;
+#if defined(__SIZEOF_INT128__)
+   return (ulong64)(((unsigned __int128)a * b) >> 64);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+   return __umulh(a, b);
+#else
+   ulong64 al = a & 0xFFFFFFFFUL, ah = a >> 32;
+   ulong64 bl = b & 0xFFFFFFFFUL, bh = b >> 32;
+   ulong64 t  = ah * bl + ((al * bl) >> 32);
+   ulong64 u  = al * bh + (t & 0xFFFFFFFFUL);
+   return ah * bh + (t >> 32) + (u >> 32);
+#endif
+}
 
-   LTC_ARGCHK(N != NULL);
+/* x mod m for x < m * 2^32; q undershoots x / m by at most one */
+static LTC_INLINE ulong64 s_barrett(ulong64 x, ulong32 m, ulong64 mu)
+{
+   ulong64 r = x - s_mulhi(x, mu) * m;
+   return (r >= m) ? r - m : r;
+}
 
-   /* get type */
-   if (len < 0) {
-      type = USE_BBS;
-      len = -len;
+static void s_sieve_done(prime_sieve *s)
+{
+   if (s->primes != NULL) XFREE(s->primes);
+   if (s->groups != NULL) XFREE(s->groups);
+   if (s->words  != NULL) XFREE(s->words);
+}
+
+static int s_sieve_init(prime_sieve *s, long len, int type)
+{
+   unsigned char *composite;
+   ulong64        m;
+   int            n, x, y, g;
+
+   XMEMSET(s, 0, sizeof(*s));
+   s->len  = len;
+   s->type = type;
+
+   /* Eratosthenes over the odd numbers, composite[i] standing for 2i+1 */
+   composite = XCALLOC(1, LTC_RAND_PRIME_SIEVE_LIMIT / 2);
+   s->primes = XCALLOC(LTC_RAND_PRIME_SIEVE_LIMIT / 2, sizeof(s->primes[0]));
+   s->groups = XCALLOC(LTC_RAND_PRIME_SIEVE_LIMIT / 2 + 4, sizeof(s->groups[0]));
+   s->words  = XCALLOC((len + 3) / 4, sizeof(s->words[0]));
+   if (composite == NULL || s->primes == NULL || s->groups == NULL || s->words == NULL) {
+      if (composite != NULL) XFREE(composite);
+      s_sieve_done(s);
+      return CRYPT_MEM;
+   }
+
+   n = 0;
+   for (x = 1; x < LTC_RAND_PRIME_SIEVE_LIMIT / 2; x++) {
+      if (composite[x] == 0) {
+         s->primes[n++] = (unsigned short)(2 * x + 1);
+         for (y = 3 * x + 1; y < LTC_RAND_PRIME_SIEVE_LIMIT / 2; y += 2 * x + 1) {
+            composite[y] = 1;
+         }
+      }
+   }
+   XFREE(composite);
+
+   /* pack the primes into 32-bit moduli */
+   g = 0;
+   for (x = 0; x < n; g++) {
+      s->groups[g].first = x;
+      for (m = 1; x < n && m * s->primes[x] <= 0xFFFFFFFFUL; x++) {
+         m *= s->primes[x];
+      }
+      s->groups[g].m     = (ulong32)m;
+      s->groups[g].mu    = ((ulong64)-1) / m;
+      s->groups[g].count = x - s->groups[g].first;
+   }
+   for (; g % 4 != 0; g++) {
+      s->groups[g].m     = 1;
+      s->groups[g].mu    = (ulong64)-1;
+      s->groups[g].first = n;
+      s->groups[g].count = 0;
+   }
+   s->ngroups = g;
+   return CRYPT_OK;
+}
+
+/* non-zero if the big-endian candidate in buf has a prime factor in the
+ * sieve; buf is at least 2^15, so that factor is never the candidate itself */
+static int s_sieve_rejects(const prime_sieve *s, const unsigned char *buf, long len)
+{
+   const sieve_group *g;
+   ulong64 r[4];
+   ulong32 w;
+   long    nwords, x, y;
+   int     k, z;
+
+   /* split into words, the top one taking the bytes that do not fill one */
+   nwords = 0;
+   if (len % 4 != 0) {
+      for (w = 0, x = 0; x < len % 4; x++) {
+         w = (w << 8) | buf[x];
+      }
+      s->words[nwords++] = w;
+   }
+   for (x = len % 4; x < len; x += 4) {
+      LOAD32H(s->words[nwords], buf + x);
+      nwords++;
+   }
+
+   /* reduce by four moduli at a time to overlap the multiplications */
+   for (k = 0; k < s->ngroups; k += 4) {
+      g = s->groups + k;
+      r[0] = r[1] = r[2] = r[3] = 0;
+      for (y = 0; y < nwords; y++) {
+         w = s->words[y];
+         r[0] = s_barrett((r[0] << 32) | w, g[0].m, g[0].mu);
+         r[1] = s_barrett((r[1] << 32) | w, g[1].m, g[1].mu);
+         r[2] = s_barrett((r[2] << 32) | w, g[2].m, g[2].mu);
+         r[3] = s_barrett((r[3] << 32) | w, g[3].m, g[3].mu);
+      }
+      for (z = 0; z < 4; z++) {
+         for (x = g[z].first; x < g[z].first + g[z].count; x++) {
+            if ((ulong32)r[z] % s->primes[x] == 0) {
+               return 1;
+            }
+         }
+      }
+   }
+   return 0;
+}
+
+/* munge buf into a candidate and test it; N holds it when *res is LTC_MP_YES */
+static int s_test_candidate(prime_sieve *s, unsigned char *buf, void *N, int *res)
+{
+   int err;
+
+   /* munge bits */
+   buf[0]        |= 0x80 | 0x40;
+   buf[s->len-1] |= 0x01 | ((s->type & USE_BBS) ? 0x02 : 0x00);
+
+   /* a small factor makes it composite, which the primality test below
+    * would reject as well; skip loading and testing it */
+   if (s_sieve_rejects(s, buf, s->len)) {
+      *res = LTC_MP_NO;
+      return CRYPT_OK;
+   }
+
+   /* load value */
+   if ((err = mp_read_unsigned_bin(N, buf, s->len)) != CRYPT_OK) {
+      return err;
+   }
+
+   /* test */
+   return mp_prime_is_prime(N, LTC_MILLER_RABIN_REPS, res);
+}
+
+/* split the signed size rand_prime takes into octets and type */
+static int s_prime_size(long *len, int *type)
+{
+   if (*len < 0) {
+      *type = USE_BBS;
+      *len = -*len;
    } else {
-      type = 0;
+      *type = 0;
    }
 
    /* allow sizes between 2 and 512 bytes for a prime size */
-   if (len < 2 || len > 512) {
+   if (*len < 2 || *len > 512) {
       return CRYPT_INVALID_PRIME_SIZE;
    }
+   return CRYPT_OK;
+}
+
+int rand_prime(void *N, long len, prng_state *prng, int wprng)
+{
+   prime_sieve    sieve;
+   int            err, res, type;
+   unsigned char *buf;
+
+   LTC_ARGCHK(N != NULL);
+
+   /* get type */
+   if ((err = s_prime_size(&len, &type)) != CRYPT_OK) {
+      return err;
+   }
 
    /* valid PRNG? Better be! */
    if ((err = prng_is_valid(wprng)) != CRYPT_OK) {
@@ -48,38 +237,101 @@ int rand_prime(void *N, long len, prng_state *prng, int wprng)
        return CRYPT_MEM;
    }
 
+   if ((err = s_sieve_init(&sieve, len, type)) != CRYPT_OK) {
+      XFREE(buf);
+      return err;
+   }
+
    do {
       /* generate value */
       if (prng_descriptor[wprng].read(buf, len, prng) != (unsigned long)len) {
-         XFREE(buf);
-         return CRYPT_ERROR_READPRNG;
+         err = CRYPT_ERROR_READPRNG;
+         goto LBL_ERR;
       }
 
-      /* munge bits */
-      buf[0]     |= 0x80 | 0x40;
-      buf[len-1] |= 0x01 | ((type & USE_BBS) ? 0x02 : 0x00);
-
-      /* load value */
-      if ((err = mp_read_unsigned_bin(N, buf, len)) != CRYPT_OK) {
-         XFREE(buf);
-         return err;
-      }
-
-      /* test */
-      if ((err = mp_prime_is_prime(N, LTC_MILLER_RABIN_REPS, &res)) != CRYPT_OK) {
-         XFREE(buf);
-         return err;
+      if ((err = s_test_candidate(&sieve, buf, N, &res)) != CRYPT_OK) {
+         goto LBL_ERR;
       }
    } while (res == LTC_MP_NO);
 
+   err = CRYPT_OK;
+LBL_ERR:
 #ifdef LTC_CLEAN_STACK
    zeromem(buf, len);
+   zeromem(sieve.words, ((len + 3) / 4) * sizeof(sieve.words[0]));
 #endif
 
+   s_sieve_done(&sieve);
    XFREE(buf);
+   return err;
+}
+
+/**
+  Set up to test rand_prime candidates that the caller draws itself, e.g. to
+  test several at once.  A tester must only be used by one thread at a time.
+  @param tester  [out] The tester, free it with rand_prime_tester_done()
+  @param len     The size of the prime in octets, negative for a Blum prime as with rand_prime()
+  @return CRYPT_OK if successful
+*/
+int rand_prime_tester_init(void **tester, long len)
+{
+   prime_sieve *s;
+   int          err, type;
+
+   LTC_ARGCHK(tester != NULL);
+
+   if ((err = s_prime_size(&len, &type)) != CRYPT_OK) {
+      return err;
+   }
+
+   s = XMALLOC(sizeof(*s));
+   if (s == NULL) {
+      return CRYPT_MEM;
+   }
+   if ((err = s_sieve_init(s, len, type)) != CRYPT_OK) {
+      XFREE(s);
+      return err;
+   }
+   *tester = s;
    return CRYPT_OK;
 }
 
+/**
+  Test a candidate the way rand_prime() tests the octets it reads
+  @param tester  The tester from rand_prime_tester_init()
+  @param buf     The candidate, as many octets as the prime size; its top and bottom bits are set in place
+  @param N       [out] The candidate as a number, valid when *res is LTC_MP_YES
+  @param res     [out] LTC_MP_YES if rand_prime() would have returned it
+  @return CRYPT_OK if successful
+*/
+int rand_prime_test(void *tester, unsigned char *buf, void *N, int *res)
+{
+   LTC_ARGCHK(tester != NULL);
+   LTC_ARGCHK(buf    != NULL);
+   LTC_ARGCHK(N      != NULL);
+   LTC_ARGCHK(res    != NULL);
+
+   return s_test_candidate(tester, buf, N, res);
+}
+
+/**
+  Free a tester
+  @param tester  The tester from rand_prime_tester_init()
+*/
+void rand_prime_tester_done(void *tester)
+{
+   prime_sieve *s = tester;
+
+   if (s == NULL) {
+      return;
+   }
+#ifdef LTC_CLEAN_STACK
+   zeromem(s->words, ((s->len + 3) / 4) * sizeof(s->words[0]));
+#endif
+   s_sieve_done(s);
+   XFREE(s);
+}
+
 #endif /* LTC_NO_MATH */
 
 
@@ -16,6 +16,34 @@
 
 #ifdef LTC_CTR_MODE
 
+/* counter blocks encrypted together by the bulk path of _ctr_encrypt */
+#ifndef LTC_CTR_BLOCKS
+   #define LTC_CTR_BLOCKS 8
+#endif
+
+static void _ctr_increment(symmetric_CTR *ctr)
+{
+   int x;
+
+   if (ctr->mode == CTR_COUNTER_LITTLE_ENDIAN) {
+      /* little-endian */
+      for (x = 0; x < ctr->ctrlen; x++) {
+         ctr->ctr[x] = (ctr->ctr[x] + (unsigned char)1) & (unsigned char)255;
+         if (ctr->ctr[x] != (unsigned char)0) {
+            break;
+         }
+      }
+   } else {
+      /* big-endian */
+      for (x = ctr->blocklen-1; x >= ctr->ctrlen; x--) {
+         ctr->ctr[x] = (ctr->ctr[x] + (unsigned char)1) & (unsigned char)255;
+         if (ctr->ctr[x] != (unsigned char)0) {
+            break;
+         }
+      }
+   }
+}
+
 /**
   CTR encrypt software implementation
   @param pt     Plaintext
@@ -26,41 +54,67 @@
 */
 static int _ctr_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long len, symmetric_CTR *ctr)
 {
-   int x, err;
+   unsigned char buf[LTC_CTR_BLOCKS * MAXBLOCKSIZE];
+   unsigned long n, i;
+   int err;
 
    while (len) {
-      /* is the pad empty? */
-      if (ctr->padlen == ctr->blocklen) {
-         /* increment counter */
-         if (ctr->mode == CTR_COUNTER_LITTLE_ENDIAN) {
-            /* little-endian */
-            for (x = 0; x < ctr->ctrlen; x++) {
-               ctr->ctr[x] = (ctr->ctr[x] + (unsigned char)1) & (unsigned char)255;
-               if (ctr->ctr[x] != (unsigned char)0) {
-                  break;
-               }
+      /* whole blocks: up to LTC_CTR_BLOCKS counters at once, through accel_ecb_encrypt if there is one */
+      if ((ctr->padlen == ctr->blocklen) && (len >= 2 * (unsigned long)ctr->blocklen)) {
+         n = len / ctr->blocklen;
+         if (n > LTC_CTR_BLOCKS) {
+            n = LTC_CTR_BLOCKS;
+         }
+         for (i = 0; i < n; i++) {
+            _ctr_increment(ctr);
+            XMEMCPY(buf + i * ctr->blocklen, ctr->ctr, ctr->blocklen);
+         }
+         if (cipher_descriptor[ctr->cipher].accel_ecb_encrypt != NULL) {
+            if ((err = cipher_descriptor[ctr->cipher].accel_ecb_encrypt(buf, buf, n, &ctr->key)) != CRYPT_OK) {
+               goto LBL_ERR;
             }
          } else {
-            /* big-endian */
-            for (x = ctr->blocklen-1; x >= ctr->ctrlen; x--) {
-               ctr->ctr[x] = (ctr->ctr[x] + (unsigned char)1) & (unsigned char)255;
-               if (ctr->ctr[x] != (unsigned char)0) {
-                  break;
+            for (i = 0; i < n; i++) {
+               if ((err = cipher_descriptor[ctr->cipher].ecb_encrypt(buf + i * ctr->blocklen, buf + i * ctr->blocklen, &ctr->key)) != CRYPT_OK) {
+                  goto LBL_ERR;
                }
             }
          }
+         n *= ctr->blocklen;
+#ifdef LTC_FAST
+         for (i = 0; i < n; i += sizeof(LTC_FAST_TYPE)) {
+            *(LTC_FAST_TYPE_PTR_CAST((unsigned char *)ct + i)) = *(LTC_FAST_TYPE_PTR_CAST((unsigned char *)pt + i)) ^
+                                                           *(LTC_FAST_TYPE_PTR_CAST(buf + i));
+         }
+#else
+         for (i = 0; i < n; i++) {
+            ct[i] = pt[i] ^ buf[i];
+         }
+#endif
+         /* the last block of key stream is the used up pad */
+         XMEMCPY(ctr->pad, buf + n - ctr->blocklen, ctr->blocklen);
+         pt  += n;
+         ct  += n;
+         len -= n;
+         continue;
+      }
+
+      /* is the pad empty? */
+      if (ctr->padlen == ctr->blocklen) {
+         /* increment counter */
+         _ctr_increment(ctr);
 
          /* encrypt it */
          if ((err = cipher_descriptor[ctr->cipher].ecb_encrypt(ctr->ctr, ctr->pad, &ctr->key)) != CRYPT_OK) {
-            return err;
+            goto LBL_ERR;
          }
          ctr->padlen = 0;
       }
 #ifdef LTC_FAST
       if ((ctr->padlen == 0) && (len >= (unsigned long)ctr->blocklen)) {
-         for (x = 0; x < ctr->blocklen; x += sizeof(LTC_FAST_TYPE)) {
-            *(LTC_FAST_TYPE_PTR_CAST((unsigned char *)ct + x)) = *(LTC_FAST_TYPE_PTR_CAST((unsigned char *)pt + x)) ^
-                                                           *(LTC_FAST_TYPE_PTR_CAST((unsigned char *)ctr->pad + x));
+         for (i = 0; i < (unsigned long)ctr->blocklen; i += sizeof(LTC_FAST_TYPE)) {
+            *(LTC_FAST_TYPE_PTR_CAST((unsigned char *)ct + i)) = *(LTC_FAST_TYPE_PTR_CAST((unsigned char *)pt + i)) ^
+                                                           *(LTC_FAST_TYPE_PTR_CAST((unsigned char *)ctr->pad + i));
          }
        pt         += ctr->blocklen;
        ct         += ctr->blocklen;
@@ -72,7 +126,13 @@ static int _ctr_encrypt(const unsigned char *pt, unsigned char *ct, unsigned lon
       *ct++ = *pt++ ^ ctr->pad[ctr->padlen++];
       --len;
    }
-   return CRYPT_OK;
+   err = CRYPT_OK;
+
+LBL_ERR:
+#ifdef LTC_CLEAN_STACK
+   zeromem(buf, sizeof(buf));
+#endif
+   return err;
 }
 
 /**
@@ -107,8 +167,10 @@ int ctr_encrypt(const unsigned char *pt, unsigned char *ct, unsigned long len, s
    }
 #endif
 
-   /* handle acceleration only if pad is empty, accelerator is present and length is >= a block size */
-   if ((cipher_descriptor[ctr->cipher].accel_ctr_encrypt != NULL) && (len >= (unsigned long)ctr->blocklen)) {
+   /* handle acceleration only if pad is empty, accelerator is present and length is >= a block size;
+      the accelerator only gets the endianness, so the counter has to span the whole block */
+   if ((cipher_descriptor[ctr->cipher].accel_ctr_encrypt != NULL) && (len >= (unsigned long)ctr->blocklen) &&
+       (ctr->ctrlen == ((ctr->mode == CTR_COUNTER_LITTLE_ENDIAN) ? ctr->blocklen : 0))) {
      if (ctr->padlen < ctr->blocklen) {
        fr = ctr->blocklen - ctr->padlen;
        if ((err = _ctr_encrypt(pt, ct, fr, ctr)) != CRYPT_OK) {
@@ -16,6 +16,8 @@
 
 #ifdef LTC_CHACHA
 
+const ltc_chacha_accel_descriptor *ltc_chacha_accel = NULL;
+
 #define QUARTERROUND(a,b,c,d) \
   x[a] += x[b]; x[d] = ROL(x[d] ^ x[a], 16); \
   x[c] += x[d]; x[b] = ROL(x[b] ^ x[c], 12); \
@@ -54,7 +56,7 @@ static void _chacha_block(unsigned char *output, const ulong32 *input, int round
 int chacha_crypt(chacha_state *st, const unsigned char *in, unsigned long inlen, unsigned char *out)
 {
    unsigned char buf[64];
-   unsigned long i, j;
+   unsigned long i, j, n;
 
    if (inlen == 0) return CRYPT_OK; /* nothing to do */
 
@@ -71,6 +73,19 @@ int chacha_crypt(chacha_state *st, const unsigned char *in, unsigned long inlen,
       out += j;
       in  += j;
    }
+   if (ltc_chacha_accel != NULL && inlen >= 64) {
+      /* the whole blocks up to the one with an all-ones counter word, which is left
+         to the loop below for its carry or CRYPT_OVERFLOW */
+      n = MIN(inlen / 64, (unsigned long)(0xFFFFFFFFUL - st->input[12]));
+      if (n > 0) {
+         ltc_chacha_accel->crypt(st->input, st->rounds, in, out, n);
+         st->input[12] += (ulong32)n;
+         inlen -= n * 64;
+         if (inlen == 0) return CRYPT_OK;
+         out += n * 64;
+         in  += n * 64;
+      }
+   }
    for (;;) {
      _chacha_block(buf, st->input, st->rounds);
      if (st->ivlen == 8) {
@@ -9,37 +9,53 @@
  */
 #include <tfm_private.h>
 
+/* one = R mod P and g = G * R mod P for the Montgomery system of P.  Given
+ * rr = R**2 mod P and its mp, neither takes a division. */
+static int fp_exptmod_setup(fp_int * G, fp_int * P, fp_digit *mp, fp_int * rr, fp_int * one, fp_int * g)
+{
+  int err;
+
+  if (fp_cmp_mag(P, G) != FP_GT) {
+     /* G > P so we reduce it first */
+     fp_mod(G, P, g);
+  } else {
+     fp_copy(G, g);
+  }
+
+  if (rr == NULL) {
+     if ((err = fp_montgomery_setup (P, mp)) != FP_OKAY) {
+        return err;
+     }
+     fp_montgomery_calc_normalization (one, P);
+     fp_mulmod (g, one, P, g);
+  } else {
+     fp_copy(rr, one);
+     fp_montgomery_reduce(one, P, *mp);
+     fp_mul(g, rr, g);
+     fp_montgomery_reduce(g, P, *mp);
+  }
+  return FP_OKAY;
+}
+
 #ifdef TFM_TIMING_RESISTANT
 
 /* timing resistant montgomery ladder based exptmod 
 
    Based on work by Marc Joye, Sung-Ming Yen, "The Montgomery Powering Ladder", Cryptographic Hardware and Embedded Systems, CHES 2002
 */
-static int _fp_exptmod(fp_int * G, fp_int * X, fp_int * P, fp_int * Y)
+static int _fp_exptmod(fp_int * G, fp_int * X, fp_int * P, fp_digit mp, fp_int * rr, fp_int * Y)
 {
   fp_int   R[2];
-  fp_digit buf, mp;
+  fp_digit buf;
   int      err, bitcnt, digidx, y;
 
-  /* now setup montgomery  */
-  if ((err = fp_montgomery_setup (P, &mp)) != FP_OKAY) {
-     return err;
-  }
-
   fp_init(&R[0]);   
   fp_init(&R[1]);   
    
-  /* now we need R mod m */
-  fp_montgomery_calc_normalization (&R[0], P);
-
-  /* now set R[0][1] to G * R mod m */
-  if (fp_cmp_mag(P, G) != FP_GT) {
-     /* G > P so we reduce it first */
-     fp_mod(G, P, &R[1]);
-  } else {
-     fp_copy(G, &R[1]);
+  /* now we need R mod m, and R[1] = G * R mod m */
+  if ((err = fp_exptmod_setup(G, P, &mp, rr, &R[0], &R[1])) != FP_OKAY) {
+     return err;
   }
-  fp_mulmod (&R[1], &R[0], P, &R[1]);
 
   /* for j = t-1 downto 0 do
         r_!k = R0*R1; r_k = r_k^2
@@ -78,13 +94,150 @@ static int _fp_exptmod(fp_int * G, fp_int * X, fp_int * P, fp_int * Y)
 
 #else
 
+/* Moduli of 16, 32 and 64 digits (1024/2048/4096 bits with 64-bit digits, the
+ * primes and moduli of RSA keys) go through fp_exptmod_fixed.i, specialised
+ * for their size.  Both products need twice the size of the modulus.
+ *
+ * Without asm the rows are plain C.  On x86-64 they are MULX/ADCX/ADOX when
+ * the CPU has them; otherwise the generic code below, whose comba asm beats
+ * the C rows, is kept.
+ */
+#if !defined(TFM_ASM) || defined(TFM_X86_64)
+
+#define FP_FIXED_MAX  (FP_SIZE/2)
+
+/* the squaring macros of the comba squarers */
+#define TFM_DEFINES
+#include "../sqr/fp_sqr_comba.c"
+
+#if defined(TFM_X86_64)
+#include <cpuid.h>
+
+/* MULX multiplies without touching the flags, so ADCX can carry the high
+ * words into the next column while ADOX carries t, two independent chains.
+ * t[0..8) += u * a[0..8) + cy, cy = the carry out */
+#define FP_ROW8_ADX(t, u, a, cy)                            \
+asm(                                                        \
+   "xorl   %%eax,%%eax              \n\t"                   \
+   "mulxq  0x00(%[src]),%%rax,%%r9  \n\t"                   \
+   "adcxq  %[c],%%rax               \n\t"                   \
+   "adoxq  0x00(%[dst]),%%rax       \n\t"                   \
+   "movq   %%rax,0x00(%[dst])       \n\t"                   \
+   "mulxq  0x08(%[src]),%%rax,%%r10 \n\t"                   \
+   "adcxq  %%r9,%%rax               \n\t"                   \
+   "adoxq  0x08(%[dst]),%%rax       \n\t"                   \
+   "movq   %%rax,0x08(%[dst])       \n\t"                   \
+   "mulxq  0x10(%[src]),%%rax,%%r9  \n\t"                   \
+   "adcxq  %%r10,%%rax              \n\t"                   \
+   "adoxq  0x10(%[dst]),%%rax       \n\t"                   \
+   "movq   %%rax,0x10(%[dst])       \n\t"                   \
+   "mulxq  0x18(%[src]),%%rax,%%r10 \n\t"                   \
+   "adcxq  %%r9,%%rax               \n\t"                   \
+   "adoxq  0x18(%[dst]),%%rax       \n\t"                   \
+   "movq   %%rax,0x18(%[dst])       \n\t"                   \
+   "mulxq  0x20(%[src]),%%rax,%%r9  \n\t"                   \
+   "adcxq  %%r10,%%rax              \n\t"                   \
+   "adoxq  0x20(%[dst]),%%rax       \n\t"                   \
+   "movq   %%rax,0x20(%[dst])       \n\t"                   \
+   "mulxq  0x28(%[src]),%%rax,%%r10 \n\t"                   \
+   "adcxq  %%r9,%%rax               \n\t"                   \
+   "adoxq  0x28(%[dst]),%%rax       \n\t"                   \
+   "movq   %%rax,0x28(%[dst])       \n\t"                   \
+   "mulxq  0x30(%[src]),%%rax,%%r9  \n\t"                   \
+   "adcxq  %%r10,%%rax              \n\t"                   \
+   "adoxq  0x30(%[dst]),%%rax       \n\t"                   \
+   "movq   %%rax,0x30(%[dst])       \n\t"                   \
+   "mulxq  0x38(%[src]),%%rax,%%r10 \n\t"                   \
+   "adcxq  %%r9,%%rax               \n\t"                   \
+   "adoxq  0x38(%[dst]),%%rax       \n\t"                   \
+   "movq   %%rax,0x38(%[dst])       \n\t"                   \
+   "movl   $0,%%eax                 \n\t"                   \
+   "adcxq  %%rax,%%r10              \n\t"                   \
+   "adoxq  %%rax,%%r10              \n\t"                   \
+   "movq   %%r10,%[c]               \n\t"                   \
+: [c]"+r"(cy), "+m"(*(fp_digit (*)[8])(t))                  \
+: [dst]"r"(t), [src]"r"(a), "d"(u), "m"(*(const fp_digit (*)[8])(a))\
+: "%rax", "%r9", "%r10", "cc")
+
+/* t[0..n) += u * a[0..n), cy = the carry out, for n a multiple of 8 */
+#define FP_ROW_ADX(t, u, a, n, cy)                              \
+   do { fp_digit *_t = (t), _u = (u); const fp_digit *_a = (a); \
+      int _n;                                                   \
+      cy = 0;                                                   \
+      for (_n = (n); _n > 0; _n -= 8) {                         \
+         FP_ROW8_ADX(_t, _u, _a, cy);                           \
+         _t += 8;                                               \
+         _a += 8;                                               \
+      }                                                         \
+   } while (0)
+
+/* BMI2 (MULX) and ADX, from CPUID leaf 7 */
+static int fp_have_adx(void)
+{
+   static volatile int detected = 0, have = 0;
+   unsigned int a, b, c, d;
+
+   if (!detected) {
+      if (__get_cpuid_max(0, NULL) >= 7) {
+         __cpuid_count(7, 0, a, b, c, d);
+         have = (b & (1u << 8)) && (b & (1u << 19));
+      }
+      detected = 1;
+   }
+   return have;
+}
+
+#define FP_FIXED_ROW     FP_ROW_ADX
+#define FP_FIXED_USABLE  fp_have_adx()
+
+#else
+
+/* t[0..n) += u * a[0..n), cy = the carry out */
+#define FP_ROW(t, u, a, n, cy)                                  \
+   do { fp_digit *_t = (t), _u = (u); const fp_digit *_a = (a); \
+      fp_word _w; int _n;                                       \
+      cy = 0;                                                   \
+      for (_n = (n); _n > 0; _n--) {                            \
+         _w    = ((fp_word)_u) * ((fp_word)*_a++) + *_t + cy;   \
+         *_t++ = (fp_digit)_w;                                  \
+         cy    = (fp_digit)(_w >> DIGIT_BIT);                   \
+      }                                                         \
+   } while (0)
+
+#define FP_FIXED_ROW     FP_ROW
+#define FP_FIXED_USABLE  1
+
+#endif
+
+#define FP_FIXED_CAT(name, n)  name ## _ ## n
+#define FP_FIXED_NAME(name, n) FP_FIXED_CAT(name, n)
+#define FP_FIXED(name)         FP_FIXED_NAME(name, FP_FIXED_N)
+
+#if FP_FIXED_MAX >= 16
+   #define FP_FIXED_N 16
+   #include "fp_exptmod_fixed.i"
+   #undef FP_FIXED_N
+#endif
+#if FP_FIXED_MAX >= 32
+   #define FP_FIXED_N 32
+   #include "fp_exptmod_fixed.i"
+   #undef FP_FIXED_N
+#endif
+#if FP_FIXED_MAX >= 64
+   #define FP_FIXED_N 64
+   #include "fp_exptmod_fixed.i"
+   #undef FP_FIXED_N
+#endif
+
+#endif
+
 /* y = g**x (mod b) 
  * Some restrictions... x must be positive and < b
  */
-static int _fp_exptmod(fp_int * G, fp_int * X, fp_int * P, fp_int * Y)
+static int _fp_exptmod(fp_int * G, fp_int * X, fp_int * P, fp_digit mp, fp_int * rr, fp_int * Y)
 {
   fp_int   M[64], res;
-  fp_digit buf, mp;
+  fp_digit buf;
   int      err, bitbuf, bitcpy, bitcnt, mode, digidx, x, y, winsize;
 
   /* find window size */
@@ -101,14 +254,26 @@ static int _fp_exptmod(fp_int * G, fp_int * X, fp_int * P, fp_int * Y)
     winsize = 6;
   } 
 
+  /* sizes with their own code */
+#if defined(FP_FIXED_ROW)
+  if (FP_FIXED_USABLE) {
+    switch (P->used) {
+#if FP_FIXED_MAX >= 16
+      case 16: return _fp_exptmod_16(G, X, P, mp, rr, Y, winsize);
+#endif
+#if FP_FIXED_MAX >= 32
+      case 32: return _fp_exptmod_32(G, X, P, mp, rr, Y, winsize);
+#endif
+#if FP_FIXED_MAX >= 64
+      case 64: return _fp_exptmod_64(G, X, P, mp, rr, Y, winsize);
+#endif
+    }
+  }
+#endif
+
   /* init M array */
   memset(M, 0, sizeof(M)); 
 
-  /* now setup montgomery  */
-  if ((err = fp_montgomery_setup (P, &mp)) != FP_OKAY) {
-     return err;
-  }
-
   /* setup result */
   fp_init(&res);
 
@@ -119,17 +284,10 @@ static int _fp_exptmod(fp_int * G, fp_int * X, fp_int * P, fp_int * Y)
    * The first half of the table is not computed though accept for M[0] and M[1]
    */
 
-   /* now we need R mod m */
-   fp_montgomery_calc_normalization (&res, P);
-
-   /* now set M[1] to G * R mod m */
-   if (fp_cmp_mag(P, G) != FP_GT) {
-      /* G > P so we reduce it first */
-      fp_mod(G, P, &M[1]);
-   } else {
-      fp_copy(G, &M[1]);
+   /* now we need R mod m, and M[1] = G * R mod m */
+   if ((err = fp_exptmod_setup(G, P, &mp, rr, &res, &M[1])) != FP_OKAY) {
+      return err;
    }
-   fp_mulmod (&M[1], &res, P, &M[1]);
 
   /* compute the value at M[1<<(winsize-1)] by squaring M[1] (winsize-1) times */
   fp_copy (&M[1], &M[1 << (winsize - 1)]);
@@ -239,6 +397,26 @@ static int _fp_exptmod(fp_int * G, fp_int * X, fp_int * P, fp_int * Y)
 
 #endif
 
+/* the kernels for moduli of m->used digits, NULL if there are none */
+const fp_fixed_ops *fp_fixed_get(fp_int *m)
+{
+#if !defined(TFM_TIMING_RESISTANT) && defined(FP_FIXED_ROW)
+   if (FP_FIXED_USABLE) {
+      switch (m->used) {
+#if FP_FIXED_MAX >= 16
+         case 16: return &fp_fixed_ops_16;
+#endif
+#if FP_FIXED_MAX >= 32
+         case 32: return &fp_fixed_ops_32;
+#endif
+#if FP_FIXED_MAX >= 64
+         case 64: return &fp_fixed_ops_64;
+#endif
+      }
+   }
+#endif
+   return NULL;
+}
 
 int fp_exptmod(fp_int * G, fp_int * X, fp_int * P, fp_int * Y)
 {
@@ -260,15 +438,88 @@ int fp_exptmod(fp_int * G, fp_int * X, fp_int * P, fp_int * Y)
          return err;
       }
       X->sign = FP_ZPOS;
-      err =  _fp_exptmod(&tmp, X, P, Y);
+      err =  _fp_exptmod(&tmp, X, P, 0, NULL, Y);
       if (X != Y) {
          X->sign = FP_NEG;
       }
       return err;
    } else {
       /* Positive exponent so just exptmod */
-      return _fp_exptmod(G, X, P, Y);
+      return _fp_exptmod(G, X, P, 0, NULL, Y);
+   }
+}
+
+/* Y = G**65537 mod P, the usual RSA public exponent: G * R squared 16 times,
+ * then a Montgomery multiply by G itself, which also leaves Montgomery form.
+ * 18 products in all, where the window needs a table and two more. */
+static int _fp_exptmod_f4(fp_int * G, fp_int * P, fp_digit mp, fp_int * rr, fp_int * Y)
+{
+  const fp_fixed_ops *ops;
+  fp_digit a[FP_SIZE/2], g[FP_SIZE/2];
+  fp_int   tmp, gr;
+  int      x;
+
+  fp_init(&tmp);
+  if (fp_cmp_mag(P, G) != FP_GT) {
+     /* G > P so we reduce it first */
+     fp_mod(G, P, &tmp);
+  } else {
+     fp_copy(G, &tmp);
+  }
+
+  /* G * R mod P */
+  fp_init(&gr);
+  fp_mul(&tmp, rr, &gr);
+  fp_montgomery_reduce(&gr, P, mp);
+
+  ops = fp_fixed_get(P);
+  if (ops == NULL) {
+     for (x = 0; x < 16; x++) {
+        fp_sqr(&gr, &gr);
+        fp_montgomery_reduce(&gr, P, mp);
+     }
+     fp_mul(&gr, &tmp, Y);
+     fp_montgomery_reduce(Y, P, mp);
+     return FP_OKAY;
+  }
+
+  for (x = 0; x < ops->size; x++) {
+     a[x] = (x < gr.used) ? gr.dp[x] : 0;
+     g[x] = (x < tmp.used) ? tmp.dp[x] : 0;
+  }
+  for (x = 0; x < 16; x++) {
+     ops->sqr(a, a, P->dp, mp);
+  }
+  ops->mul(a, a, g, P->dp, mp);
+
+  fp_zero(Y);
+  for (x = 0; x < ops->size; x++) {
+     Y->dp[x] = a[x];
+  }
+  Y->used = ops->size;
+  fp_clamp(Y);
+  return FP_OKAY;
+}
+
+/* fp_exptmod with the Montgomery setup of P already done, mp from
+ * fp_montgomery_setup and rr = R**2 mod P, for many powers modulo one P.
+ * X must not be negative. */
+int fp_exptmod_mont(fp_int * G, fp_int * X, fp_int * P, fp_digit mp, fp_int * rr, fp_int * Y)
+{
+#ifdef TFM_CHECK
+   /* prevent overflows */
+   if (P->used > (FP_SIZE/2)) {
+      return FP_VAL;
+   }
+#endif
+
+   if (X->sign == FP_NEG) {
+      return FP_VAL;
+   }
+   if (X->used == 1 && X->dp[0] == 65537) {
+      return _fp_exptmod_f4(G, P, mp, rr, Y);
    }
+   return _fp_exptmod(G, X, P, mp, rr, Y);
 }
 
 /* $Source$ */
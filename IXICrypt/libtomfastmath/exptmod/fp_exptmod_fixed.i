@@ -0,0 +1,219 @@
+/* TomsFastMath, a fast ISO C bignum library.
+ *
+ * This project is meant to fill in where LibTomMath
+ * falls short.  That is speed ;-)
+ *
+ * This project is public domain and free for all purposes.
+ *
+ * Tom St Denis, tomstdenis@gmail.com
+ */
+
+/* Montgomery exponentiation for moduli of exactly FP_FIXED_N digits.
+ *
+ * Included by fp_exptmod.c once per size, with
+ *   FP_FIXED_N               the number of digits
+ *   FP_FIXED(name)           name with a suffix unique to this size
+ *   FP_FIXED_ROW(t, u, a, n, cy)  t[0..n) += u * a[0..n), cy = the carry out
+ *
+ * Numbers are plain arrays of FP_FIXED_N digits, least significant first and
+ * always below the modulus, so no loop depends on "used" and no fp_int is
+ * copied, clamped or cleared between operations.
+ */
+
+/* r = t / R mod m, t holds 2*FP_FIXED_N digits and is destroyed */
+static void FP_FIXED(fp_fixed_redc)(fp_digit *r, fp_digit *t, const fp_digit *m, fp_digit mp)
+{
+   fp_digit top, cy, mu, b, mask;
+   fp_word  w;
+   int      x;
+
+   top = 0;
+   for (x = 0; x < FP_FIXED_N; x++) {
+      mu = t[x] * mp;
+      FP_FIXED_ROW(t + x, mu, m, FP_FIXED_N, cy);
+      w  = (fp_word)t[x + FP_FIXED_N] + cy + top;
+      t[x + FP_FIXED_N] = (fp_digit)w;
+      top = (fp_digit)(w >> DIGIT_BIT);
+   }
+
+   /* r = t - m if that is not negative */
+   b = 0;
+   for (x = 0; x < FP_FIXED_N; x++) {
+      w    = (fp_word)t[x + FP_FIXED_N] - m[x] - b;
+      r[x] = (fp_digit)w;
+      b    = (fp_digit)(w >> DIGIT_BIT) & 1;
+   }
+   mask = (fp_digit)0 - (top | (b ^ 1));
+   for (x = 0; x < FP_FIXED_N; x++) {
+      r[x] = (r[x] & mask) | (t[x + FP_FIXED_N] & ~mask);
+   }
+}
+
+/* r = a * b / R mod m */
+static void FP_FIXED(fp_fixed_mul)(fp_digit *r, const fp_digit *a, const fp_digit *b, const fp_digit *m, fp_digit mp)
+{
+   fp_digit t[2 * FP_FIXED_N], cy;
+   int      x;
+
+   for (x = 0; x < FP_FIXED_N; x++) {
+      t[x] = 0;
+   }
+   for (x = 0; x < FP_FIXED_N; x++) {
+      FP_FIXED_ROW(t + x, a[x], b, FP_FIXED_N, cy);
+      t[x + FP_FIXED_N] = cy;
+   }
+   FP_FIXED(fp_fixed_redc)(r, t, m, mp);
+}
+
+/* r = a * a / R mod m, the square by columns as the comba squarers do */
+static void FP_FIXED(fp_fixed_sqr)(fp_digit *r, const fp_digit *a, const fp_digit *m, fp_digit mp)
+{
+   fp_digit t[2 * FP_FIXED_N], c0, c1, c2, sc0, sc1, sc2;
+   int      ix, iy, iz;
+
+   COMBA_START;
+   CLEAR_CARRY;
+   for (ix = 0; ix < 2 * FP_FIXED_N - 1; ix++) {
+      /* the products a[iy] * a[iz], iy < iz, of this column, doubled */
+      iy = (ix < FP_FIXED_N) ? 0 : ix - FP_FIXED_N + 1;
+      iz = ix - iy;
+      if (iy < iz) {
+         SQRADDSC(a[iy], a[iz]);
+         for (++iy, --iz; iy < iz; ++iy, --iz) {
+            SQRADDAC(a[iy], a[iz]);
+         }
+         SQRADDDB;
+      }
+      if ((ix & 1) == 0) {
+         SQRADD(a[ix >> 1], a[ix >> 1]);
+      }
+      COMBA_STORE(t[ix]);
+      CARRY_FORWARD;
+   }
+   COMBA_STORE(t[2 * FP_FIXED_N - 1]);
+   COMBA_FINI;
+
+   FP_FIXED(fp_fixed_redc)(r, t, m, mp);
+}
+
+static const fp_fixed_ops FP_FIXED(fp_fixed_ops) = {
+   FP_FIXED_N, FP_FIXED(fp_fixed_mul), FP_FIXED(fp_fixed_sqr)
+};
+
+/* Y = G**X mod P, the sliding window of _fp_exptmod; P->used == FP_FIXED_N
+ * and mp, rr as for fp_exptmod_setup */
+static int FP_FIXED(_fp_exptmod)(fp_int * G, fp_int * X, fp_int * P, fp_digit mp, fp_int * rr, fp_int * Y, int winsize)
+{
+  fp_digit M[64][FP_FIXED_N], res[FP_FIXED_N], t[2 * FP_FIXED_N], buf;
+  fp_int   tmp, norm;
+  int      err, bitbuf, bitcpy, bitcnt, mode, digidx, x, y;
+
+  /* now we need R mod m, which is also 1 in Montgomery form, and
+   * M[1] = G * R mod m */
+  fp_init(&norm);
+  fp_init(&tmp);
+  if ((err = fp_exptmod_setup(G, P, &mp, rr, &norm, &tmp)) != FP_OKAY) {
+     return err;
+  }
+
+  for (x = 0; x < FP_FIXED_N; x++) {
+     M[1][x] = (x < tmp.used) ? tmp.dp[x] : 0;
+     res[x]  = (x < norm.used) ? norm.dp[x] : 0;
+  }
+
+  /* compute the value at M[1<<(winsize-1)] by squaring M[1] (winsize-1) times */
+  memcpy(M[1 << (winsize - 1)], M[1], sizeof(M[1]));
+  for (x = 0; x < (winsize - 1); x++) {
+    FP_FIXED(fp_fixed_sqr)(M[1 << (winsize - 1)], M[1 << (winsize - 1)], P->dp, mp);
+  }
+
+  /* create upper table */
+  for (x = (1 << (winsize - 1)) + 1; x < (1 << winsize); x++) {
+    FP_FIXED(fp_fixed_mul)(M[x], M[x - 1], M[1], P->dp, mp);
+  }
+
+  /* set initial mode and bit cnt */
+  mode   = 0;
+  bitcnt = 1;
+  buf    = 0;
+  digidx = X->used - 1;
+  bitcpy = 0;
+  bitbuf = 0;
+
+  for (;;) {
+    /* grab next digit as required */
+    if (--bitcnt == 0) {
+      /* if digidx == -1 we are out of digits so break */
+      if (digidx == -1) {
+        break;
+      }
+      /* read next digit and reset bitcnt */
+      buf    = X->dp[digidx--];
+      bitcnt = (int)DIGIT_BIT;
+    }
+
+    /* grab the next msb from the exponent */
+    y     = (fp_digit)(buf >> (DIGIT_BIT - 1)) & 1;
+    buf <<= (fp_digit)1;
+
+    /* skip the leading zero bits */
+    if (mode == 0 && y == 0) {
+      continue;
+    }
+
+    /* if the bit is zero and mode == 1 then we square */
+    if (mode == 1 && y == 0) {
+      FP_FIXED(fp_fixed_sqr)(res, res, P->dp, mp);
+      continue;
+    }
+
+    /* else we add it to the window */
+    bitbuf |= (y << (winsize - ++bitcpy));
+    mode    = 2;
+
+    if (bitcpy == winsize) {
+      /* ok window is filled so square as required and multiply  */
+      for (x = 0; x < winsize; x++) {
+        FP_FIXED(fp_fixed_sqr)(res, res, P->dp, mp);
+      }
+      FP_FIXED(fp_fixed_mul)(res, res, M[bitbuf], P->dp, mp);
+
+      /* empty window and reset */
+      bitcpy = 0;
+      bitbuf = 0;
+      mode   = 1;
+    }
+  }
+
+  /* if bits remain then square/multiply */
+  if (mode == 2 && bitcpy > 0) {
+    for (x = 0; x < bitcpy; x++) {
+      FP_FIXED(fp_fixed_sqr)(res, res, P->dp, mp);
+
+      /* get next bit of the window */
+      bitbuf <<= 1;
+      if ((bitbuf & (1 << winsize)) != 0) {
+        FP_FIXED(fp_fixed_mul)(res, res, M[1], P->dp, mp);
+      }
+    }
+  }
+
+  /* leave Montgomery form */
+  for (x = 0; x < FP_FIXED_N; x++) {
+     t[x] = res[x];
+     t[x + FP_FIXED_N] = 0;
+  }
+  FP_FIXED(fp_fixed_redc)(res, t, P->dp, mp);
+
+  fp_zero(Y);
+  for (x = 0; x < FP_FIXED_N; x++) {
+     Y->dp[x] = res[x];
+  }
+  Y->used = FP_FIXED_N;
+  fp_clamp(Y);
+  return FP_OKAY;
+}
+
+/* $Source$ */
+/* $Revision$ */
+/* $Date$ */
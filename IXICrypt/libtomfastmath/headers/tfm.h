@@ -450,6 +450,9 @@ void fp_montgomery_reduce(fp_int *a, fp_int *m, fp_digit mp);
 /* d = a**b (mod c) */
 int fp_exptmod(fp_int *a, fp_int *b, fp_int *c, fp_int *d);
 
+/* d = a**b (mod c), b >= 0, given mp from fp_montgomery_setup(c) and rr = R**2 (mod c) */
+int fp_exptmod_mont(fp_int *a, fp_int *b, fp_int *c, fp_digit mp, fp_int *rr, fp_int *d);
+
 /* primality stuff */
 
 /* perform a Miller-Rabin test of a to the base b and store result in "result" */
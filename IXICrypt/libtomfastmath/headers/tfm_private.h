@@ -118,6 +118,36 @@ void fp_sqr_comba64(fp_int *A, fp_int *B);
 #endif
 extern const char *fp_s_rmap;
 
+/* Montgomery products of numbers of exactly "size" digits below the modulus m,
+ * r = a * b / R mod m with R = 2**(size * DIGIT_BIT) and mp from
+ * fp_montgomery_setup */
+typedef struct {
+   int  size;
+   void (*mul)(fp_digit *r, const fp_digit *a, const fp_digit *b, const fp_digit *m, fp_digit mp);
+   void (*sqr)(fp_digit *r, const fp_digit *a, const fp_digit *m, fp_digit mp);
+} fp_fixed_ops;
+
+/* the specialised kernels of fp_exptmod for m, NULL if m->used has none */
+const fp_fixed_ops *fp_fixed_get(fp_int *m);
+
+/* Miller-Rabin state of one candidate, shared by all the bases it is tested to */
+#define FP_PRIME_CHUNK  6
+#define FP_PRIME_LANES  2
+
+typedef struct {
+   fp_int              n;
+   const fp_fixed_ops *ops;
+   fp_digit            mp;
+   /* n - 1 = 2**s * r, r odd */
+   int                 s;
+   fp_int              r;
+   /* 1 and n - 1 in Montgomery form */
+   fp_digit            one[FP_SIZE/2], minus1[FP_SIZE/2];
+} fp_prime_ctx;
+
+void fp_prime_ctx_init(fp_prime_ctx *ctx, fp_int *a);
+void fp_prime_ctx_test(fp_prime_ctx *ctx, const fp_digit *bases, int count, int *result);
+
 #endif
 
 /* $Source$ */
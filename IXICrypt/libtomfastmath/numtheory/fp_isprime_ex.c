@@ -50,9 +50,9 @@ static const fp_digit primes[FP_PRIME_SIZE] = {
 
 int fp_isprime_ex(fp_int *a, int t)
 {
-   fp_int   b;
-   fp_digit d;
-   int      r, res;
+   fp_prime_ctx ctx;
+   fp_digit     d;
+   int          r, res;
 
    if (t <= 0 || t > FP_PRIME_SIZE) {
      return FP_NO;
@@ -67,15 +67,9 @@ int fp_isprime_ex(fp_int *a, int t)
    }
 
    /* now do 't' miller rabins */
-   fp_init(&b);
-   for (r = 0; r < t; r++) {
-       fp_set(&b, primes[r]);
-       fp_prime_miller_rabin(a, &b, &res);
-       if (res == FP_NO) {
-          return FP_NO;
-       }
-   }
-   return FP_YES;
+   fp_prime_ctx_init(&ctx, a);
+   fp_prime_ctx_test(&ctx, primes, t, &res);
+   return res;
 }
 
 /* $Source$ */
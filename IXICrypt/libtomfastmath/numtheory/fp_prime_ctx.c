@@ -0,0 +1,246 @@
+/* TomsFastMath, a fast ISO C bignum library.
+ *
+ * This project is meant to fill in where LibTomMath
+ * falls short.  That is speed ;-)
+ *
+ * This project is public domain and free for all purposes.
+ *
+ * Tom St Denis, tomstdenis@gmail.com
+ */
+#include <tfm_private.h>
+
+/* Miller-Rabin tests of one candidate to many small bases.
+ *
+ * fp_prime_ctx_init does the work that only depends on the candidate n:
+ * Montgomery setup, n - 1 = 2**s * r, and 1 and n - 1 in Montgomery form.
+ *
+ * Each base b is a single digit, so b**r is taken k bits of r at a time:
+ * k squarings with the fixed size kernels of fp_exptmod, then a multiply by
+ * b**(those k bits), itself a single digit.  That is a digit times a number
+ * reduced with one quotient digit, nothing like the table and full products
+ * of a windowed exptmod.  The first base is tested on its own since it
+ * rejects nearly every composite; the rest are powered FP_PRIME_LANES at a
+ * time in step over the same chunks of r.
+ */
+
+#define FP_PRIME_BIT(a, i)  (int)(((a)->dp[(i) / DIGIT_BIT] >> ((i) % DIGIT_BIT)) & 1)
+
+static void fp_prime_copy(fp_digit *d, fp_int *a, int size)
+{
+   int x;
+
+   for (x = 0; x < size; x++) {
+      d[x] = (x < a->used) ? a->dp[x] : 0;
+   }
+}
+
+void fp_prime_ctx_init(fp_prime_ctx *ctx, fp_int *a)
+{
+   fp_int t;
+
+   fp_init_copy(&ctx->n, a);
+   ctx->ops = NULL;
+
+   /* the kernels need an odd modulus of their size, the quotient estimate
+    * of fp_prime_mul_d needs its top bit set (rand_prime sets it) */
+   if (fp_iseven(a) || fp_montgomery_setup(a, &ctx->mp) != FP_OKAY ||
+       (ctx->ops = fp_fixed_get(a)) == NULL ||
+       fp_count_bits(a) != ctx->ops->size * DIGIT_BIT) {
+      ctx->ops = NULL;
+      return;
+   }
+
+   /* n - 1 = 2**s * r */
+   fp_init_copy(&t, a);
+   fp_sub_d(&t, 1, &t);
+   ctx->s = fp_cnt_lsb(&t);
+   fp_init(&ctx->r);
+   fp_div_2d(&t, ctx->s, &ctx->r, NULL);
+
+   /* R and n - R mod n */
+   fp_montgomery_calc_normalization(&t, a);
+   fp_prime_copy(ctx->one, &t, ctx->ops->size);
+   fp_sub(a, &t, &t);
+   fp_prime_copy(ctx->minus1, &t, ctx->ops->size);
+}
+
+/* r = a * d mod m, a < m and the top bit of m set */
+static void fp_prime_mul_d(fp_digit *r, const fp_digit *a, fp_digit d, const fp_digit *m, int size)
+{
+   fp_digit t[FP_SIZE/2 + 1], q, c, b;
+   fp_word  w;
+   int      x;
+
+   c = 0;
+   for (x = 0; x < size; x++) {
+      w    = ((fp_word)a[x]) * ((fp_word)d) + c;
+      t[x] = (fp_digit)w;
+      c    = (fp_digit)(w >> DIGIT_BIT);
+   }
+   t[size] = c;
+
+   /* t < d * m, so the quotient is a digit.  From the top two digits of t
+    * and the top digit of m it is never too small and, m being normalised,
+    * at most 2 too big [HAC 14.20] */
+   w = ((((fp_word)t[size]) << DIGIT_BIT) | t[size - 1]) / m[size - 1];
+   q = (w >> DIGIT_BIT) ? (fp_digit)-1 : (fp_digit)w;
+
+   /* t -= q * m */
+   c = 0;
+   b = 0;
+   for (x = 0; x < size; x++) {
+      w    = ((fp_word)q) * ((fp_word)m[x]) + c;
+      c    = (fp_digit)(w >> DIGIT_BIT);
+      w    = ((fp_word)t[x]) - ((fp_digit)w) - b;
+      t[x] = (fp_digit)w;
+      b    = (fp_digit)(w >> DIGIT_BIT) & 1;
+   }
+   t[size] = t[size] - c - b;
+
+   /* add m back while negative */
+   while (t[size] != 0) {
+      c = 0;
+      for (x = 0; x < size; x++) {
+         w    = ((fp_word)t[x]) + m[x] + c;
+         t[x] = (fp_digit)w;
+         c    = (fp_digit)(w >> DIGIT_BIT);
+      }
+      t[size] += c;
+   }
+
+   for (x = 0; x < size; x++) {
+      r[x] = t[x];
+   }
+}
+
+/* the finish of the test from y = b**r, FP_YES if n is a probable prime */
+static int fp_prime_ctx_finish(fp_prime_ctx *ctx, fp_digit *y)
+{
+   size_t len = ctx->ops->size * sizeof(fp_digit);
+   int    j;
+
+   if (memcmp(y, ctx->one, len) == 0 || memcmp(y, ctx->minus1, len) == 0) {
+      return FP_YES;
+   }
+   for (j = 1; j < ctx->s; j++) {
+      ctx->ops->sqr(y, y, ctx->n.dp, ctx->mp);
+      if (memcmp(y, ctx->one, len) == 0) {
+         return FP_NO;
+      }
+      if (memcmp(y, ctx->minus1, len) == 0) {
+         return FP_YES;
+      }
+   }
+   return FP_NO;
+}
+
+/* tests "lanes" bases in step, FP_YES if n passes them all */
+static int fp_prime_ctx_lanes(fp_prime_ctx *ctx, const fp_digit *bases, int lanes)
+{
+   fp_digit pw[FP_PRIME_LANES][1 << FP_PRIME_CHUNK];
+   fp_digit y[FP_PRIME_LANES][FP_SIZE/2];
+   fp_digit *m = ctx->n.dp;
+   fp_word  w;
+   int      l, x, i, j, k, val, bits, size = ctx->ops->size;
+
+   /* the widest chunk for which every pw[l][x] = b**x fits a digit */
+   for (k = FP_PRIME_CHUNK; k > 1; k--) {
+      for (l = 0; l < lanes; l++) {
+         w = 1;
+         for (x = 0; x < (1 << k) - 1 && (w >> DIGIT_BIT) == 0; x++) {
+            w *= bases[l];
+         }
+         if ((w >> DIGIT_BIT) != 0) {
+            break;
+         }
+      }
+      if (l == lanes) {
+         break;
+      }
+   }
+   for (l = 0; l < lanes; l++) {
+      pw[l][0] = 1;
+      for (x = 1; x < (1 << k); x++) {
+         pw[l][x] = pw[l][x - 1] * bases[l];
+      }
+   }
+
+   /* the top chunk takes what is left over at the top of r */
+   bits = fp_count_bits(&ctx->r);
+   i    = bits - ((bits % k) ? (bits % k) : k);
+   for (val = 0, j = bits - 1; j >= i; j--) {
+      val = (val << 1) | FP_PRIME_BIT(&ctx->r, j);
+   }
+   for (l = 0; l < lanes; l++) {
+      fp_prime_mul_d(y[l], ctx->one, pw[l][val], m, size);
+   }
+
+   while (i > 0) {
+      for (j = 0; j < k; j++) {
+         for (l = 0; l < lanes; l++) {
+            ctx->ops->sqr(y[l], y[l], m, ctx->mp);
+         }
+      }
+      for (val = 0, j = i - 1, i -= k; j >= i; j--) {
+         val = (val << 1) | FP_PRIME_BIT(&ctx->r, j);
+      }
+      if (val != 0) {
+         for (l = 0; l < lanes; l++) {
+            fp_prime_mul_d(y[l], y[l], pw[l][val], m, size);
+         }
+      }
+   }
+
+   for (l = 0; l < lanes; l++) {
+      if (fp_prime_ctx_finish(ctx, y[l]) == FP_NO) {
+         return FP_NO;
+      }
+   }
+   return FP_YES;
+}
+
+/* Miller-Rabin test of the candidate of ctx to each of the "count" bases,
+ * result is FP_YES if it passes them all */
+void fp_prime_ctx_test(fp_prime_ctx *ctx, const fp_digit *bases, int count, int *result)
+{
+   fp_int b;
+   int    x, lanes, res;
+
+   *result = FP_NO;
+
+   /* candidates without kernels, one fp_prime_miller_rabin per base */
+   if (ctx->ops == NULL) {
+      fp_init(&b);
+      for (x = 0; x < count; x++) {
+         fp_set(&b, bases[x]);
+         fp_prime_miller_rabin(&ctx->n, &b, &res);
+         if (res == FP_NO) {
+            return;
+         }
+      }
+      *result = FP_YES;
+      return;
+   }
+
+   /* fp_prime_miller_rabin fails bases below 2 */
+   for (x = 0; x < count; x++) {
+      if (bases[x] <= 1) {
+         return;
+      }
+   }
+
+   for (x = 0; x < count; x += lanes) {
+      lanes = (x == 0) ? 1 : FP_PRIME_LANES;
+      if (lanes > count - x) {
+         lanes = count - x;
+      }
+      if (fp_prime_ctx_lanes(ctx, bases + x, lanes) == FP_NO) {
+         return;
+      }
+   }
+   *result = FP_YES;
+}
+
+/* $Source$ */
+/* $Revision$ */
+/* $Date$ */
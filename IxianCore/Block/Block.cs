@@ -668,6 +668,9 @@ namespace DLT
 
                 List<byte[][]> safeSigs = new List<byte[][]>(signatures);
 
+                List<byte[][]> uncheckedSigs = new List<byte[][]>();
+                List<byte[]> uncheckedPubKeys = new List<byte[]>();
+
                 foreach (byte[][] sig in safeSigs)
                 {
                     byte[] signature = sig[0];
@@ -691,13 +694,32 @@ namespace DLT
                         continue;
                     }
 
-                    if (skip_sig_verification == false && verifySignature(signature, signer_pub_key) == false)
+                    if (skip_sig_verification == false)
                     {
-                        signatures.Remove(sig);
-                        continue;
+                        uncheckedSigs.Add(sig);
+                        uncheckedPubKeys.Add(signer_pub_key);
                     }
+                }
 
-
+                // The remaining signatures are verified together, in one batch
+                if (uncheckedSigs.Count > 0)
+                {
+                    int count = uncheckedSigs.Count;
+                    byte[][] checksums = new byte[count][];
+                    byte[][] sigBytes = new byte[count][];
+                    for (int i = 0; i < count; i++)
+                    {
+                        checksums[i] = blockChecksum;
+                        sigBytes[i] = uncheckedSigs[i][0];
+                    }
+                    bool[] valid = CryptoManager.lib.verifySignatures(checksums, uncheckedPubKeys.ToArray(), sigBytes);
+                    for (int i = 0; i < count; i++)
+                    {
+                        if (valid[i] == false)
+                        {
+                            signatures.Remove(uncheckedSigs[i]);
+                        }
+                    }
                 }
 
                 if(signatures.Count == 0)
@@ -16,6 +16,8 @@ namespace DLT
 
         byte[] getSignature(byte[] input, byte[] privateKey);
         bool verifySignature(byte[] input, byte[] publicKey, byte[] signature);
+        // verifySignature for each inputs[i], publicKeys[i], signatures[i]
+        bool[] verifySignatures(byte[][] inputs, byte[][] publicKeys, byte[][] signatures);
 
         byte[] encryptWithRSA(byte[] input, byte[] publicKey);
         byte[] decryptWithRSA(byte[] input, byte[] privateKey);
@@ -60,6 +62,11 @@ namespace DLT
             return _cryptoLib.verifySignature(input, publicKey, signature);
         }
 
+        public bool[] verifySignatures(byte[][] inputs, byte[][] publicKeys, byte[][] signatures)
+        {
+            return _cryptoLib.verifySignatures(inputs, publicKeys, signatures);
+        }
+
         public byte[] encryptWithRSA(byte[] input, byte[] publicKey)
         {
             return _cryptoLib.encryptWithRSA(input, publicKey);
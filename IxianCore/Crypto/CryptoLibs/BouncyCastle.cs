@@ -12,6 +12,7 @@ using Org.BouncyCastle.Math;
 using Org.BouncyCastle.Crypto.Encodings;
 using Org.BouncyCastle.Crypto.Engines;
 using System.IO;
+using System.Runtime.InteropServices;
 using Org.BouncyCastle.OpenSsl;
 using System.Security.Cryptography;
 
@@ -191,10 +192,83 @@ namespace CryptoLibs
             }
         }
 
+        [DllImport("IXICrypt.dll", CallingConvention = CallingConvention.Cdecl)]
+        static extern IntPtr ix_rsa_signer_open(byte[] key, uint key_len);
+
+        [DllImport("IXICrypt.dll", CallingConvention = CallingConvention.Cdecl)]
+        static extern int ix_rsa_sign(IntPtr signer, byte[] msg_hash, uint hash_len, [Out] byte[] sig, uint sig_len);
+
+        [DllImport("IXICrypt.dll", CallingConvention = CallingConvention.Cdecl)]
+        static extern void ix_rsa_signer_close(IntPtr signer);
+
+        // Cleared if IXICrypt can not be loaded; signatures are then made and verified with the managed provider only
+        private static bool nativeRSA = true;
+
+        // The IXICrypt signing handle of the private key signed with last, which is usually the node's own key
+        private static byte[] signerKey = null;
+        private static IntPtr signer = IntPtr.Zero;
+        private static readonly object signerLock = new object();
+
+        // Signs with an IXICrypt handle, opening one if privateKey is not the last key used; null if IXICrypt can not sign with it
+        private byte[] getNativeSignature(byte[] input_data, byte[] privateKey)
+        {
+            byte[] hash;
+            using (var sha = new SHA512Managed())
+            {
+                hash = sha.ComputeHash(input_data);
+            }
+            lock (signerLock)
+            {
+                if (signerKey == null || !signerKey.SequenceEqual(privateKey))
+                {
+                    if (signer != IntPtr.Zero)
+                    {
+                        ix_rsa_signer_close(signer);
+                        signer = IntPtr.Zero;
+                        signerKey = null;
+                    }
+                    signer = ix_rsa_signer_open(privateKey, (uint)privateKey.Length);
+                    if (signer == IntPtr.Zero)
+                    {
+                        return null;
+                    }
+                    signerKey = (byte[])privateKey.Clone();
+                }
+                byte[] signature = new byte[1024];
+                int signature_len = ix_rsa_sign(signer, hash, (uint)hash.Length, signature, (uint)signature.Length);
+                if (signature_len <= 0)
+                {
+                    return null;
+                }
+                Array.Resize(ref signature, signature_len);
+                return signature;
+            }
+        }
+
         public byte[] getSignature(byte[] input_data, byte[] privateKey)
         {
             try
             {
+                if (nativeRSA)
+                {
+                    try
+                    {
+                        byte[] native_signature = getNativeSignature(input_data, privateKey);
+                        if (native_signature != null)
+                        {
+                            return native_signature;
+                        }
+                    }
+                    catch (DllNotFoundException)
+                    {
+                        nativeRSA = false;
+                    }
+                    catch (EntryPointNotFoundException)
+                    {
+                        nativeRSA = false;
+                    }
+                }
+
                 RSACryptoServiceProvider rsa = rsaKeyFromBytes(privateKey);
 
                 byte[] signature = rsa.SignData(input_data, CryptoConfig.MapNameToOID("SHA512"));
@@ -207,11 +281,21 @@ namespace CryptoLibs
             return null;
         }
 
-        public bool verifySignature(byte[] input_data, byte[] publicKey, byte[] signature)
+        [DllImport("IXICrypt.dll", CallingConvention = CallingConvention.Cdecl)]
+        static extern int ix_rsa_verify(byte[] pubkey, uint pubkey_len, byte[] msg_hash, uint hash_len, byte[] sig, uint sig_len);
+
+        // What ix_rsa_verify returns for a public key that rsaKeyFromBytes might read differently from IXICrypt,
+        // e.g. one with bytes after the exponent; such keys are verified with the managed provider
+        private const int nativeKeyUnhandled = -1;
+
+        // Set once testNativeVerify has run
+        private static volatile bool nativeVerifyTested = false;
+        private static readonly object nativeVerifyLock = new object();
+
+        private bool verifySignatureManaged(byte[] input_data, byte[] publicKey, byte[] signature)
         {
             try
             {
-
                 RSACryptoServiceProvider rsa = rsaKeyFromBytes(publicKey);
 
                 byte[] signature_bytes = signature;
@@ -224,6 +308,191 @@ namespace CryptoLibs
             return false;
         }
 
+        // A signature that is valid with IXICrypt and invalid without it, or the other way round, would split the
+        // nodes, so IXICrypt has to agree with the managed provider or leave the key to it. Checked with a well-formed
+        // key, which IXICrypt has to take, and keys with garbage after the exponent or with a modulus or exponent length
+        // running past the end, which rsaKeyFromBytes rejects or cuts short with Take.
+        private bool testNativeVerify()
+        {
+            RSACryptoServiceProvider rsa = new RSACryptoServiceProvider(1024);
+            RSAParameters rsaParams = rsa.ExportParameters(false);
+            byte[] data = Encoding.UTF8.GetBytes("Plain text string");
+            byte[] signature = rsa.SignData(data, CryptoConfig.MapNameToOID("SHA512"));
+            byte[] bad_signature = (byte[])signature.Clone();
+            bad_signature[bad_signature.Length - 1] ^= 1;
+            byte[] hash;
+            using (var sha = new SHA512Managed())
+            {
+                hash = sha.ComputeHash(data);
+            }
+
+            // With the header, the modulus length is at offset 5 and the exponent length right after the modulus
+            byte[] key = rsaKeyToBytes(rsa, false, false);
+            byte[] trailing_garbage = key.Concat(new byte[] { 0xFF, 0x13, 0x37, 0x00, 0x42 }).ToArray();
+            byte[] long_modulus = (byte[])key.Clone();
+            Array.Copy(BitConverter.GetBytes(rsaParams.Modulus.Length + 100), 0, long_modulus, 5, 4);
+            byte[] long_exponent = (byte[])key.Clone();
+            Array.Copy(BitConverter.GetBytes(rsaParams.Exponent.Length + 100), 0, long_exponent, 9 + rsaParams.Modulus.Length, 4);
+
+            foreach (byte[] test_key in new byte[][] { key, trailing_garbage, long_modulus, long_exponent })
+            {
+                foreach (byte[] test_signature in new byte[][] { signature, bad_signature })
+                {
+                    int native_result = ix_rsa_verify(test_key, (uint)test_key.Length, hash, (uint)hash.Length, test_signature, (uint)test_signature.Length);
+                    bool managed_result = verifySignatureManaged(data, test_key, test_signature);
+                    if (native_result == nativeKeyUnhandled ? test_key == key : (native_result == 1) != managed_result)
+                    {
+                        Logging.warn(string.Format("IXICrypt returned {0} for a {1}-byte test key, the managed provider {2}.", native_result, test_key.Length, managed_result));
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        // Whether to verify with IXICrypt; runs testNativeVerify on first use
+        private bool useNativeVerify()
+        {
+            if (nativeRSA && !nativeVerifyTested)
+            {
+                lock (nativeVerifyLock)
+                {
+                    if (!nativeVerifyTested)
+                    {
+                        nativeVerifyTested = true;
+                        if (!testNativeVerify())
+                        {
+                            Logging.error("IXICrypt does not verify RSA signatures as the managed provider does, not using it.");
+                            nativeRSA = false;
+                        }
+                    }
+                }
+            }
+            return nativeRSA;
+        }
+
+        public bool verifySignature(byte[] input_data, byte[] publicKey, byte[] signature)
+        {
+            try
+            {
+                // IXICrypt keeps recently used public keys parsed, so a repeated signer is not re-imported
+                if (useNativeVerify())
+                {
+                    try
+                    {
+                        byte[] hash;
+                        using (var sha = new SHA512Managed())
+                        {
+                            hash = sha.ComputeHash(input_data);
+                        }
+                        int native_result = ix_rsa_verify(publicKey, (uint)publicKey.Length, hash, (uint)hash.Length, signature, (uint)signature.Length);
+                        if (native_result != nativeKeyUnhandled)
+                        {
+                            return native_result == 1;
+                        }
+                    }
+                    catch (DllNotFoundException)
+                    {
+                        nativeRSA = false;
+                    }
+                    catch (EntryPointNotFoundException)
+                    {
+                        nativeRSA = false;
+                    }
+                }
+
+                return verifySignatureManaged(input_data, publicKey, signature);
+            }
+            catch (Exception e)
+            {
+                Logging.warn(string.Format("Invalid public key {0}:{1}", publicKey, e.Message));
+            }
+            return false;
+        }
+
+        [DllImport("IXICrypt.dll", CallingConvention = CallingConvention.Cdecl)]
+        static extern int ix_rsa_verify_batch(byte[] pubkeys, uint[] pubkey_lens, byte[] msg_hashes, byte[] sigs, uint[] sig_lens, int count, [Out] int[] results);
+
+        // Verifies all signatures in one IXICrypt call, which spreads them over all cores
+        public bool[] verifySignatures(byte[][] inputs, byte[][] publicKeys, byte[][] signatures)
+        {
+            int count = inputs.Length;
+            bool[] results = new bool[count];
+            if (count > 0 && useNativeVerify())
+            {
+                try
+                {
+                    // Items are packed one after another; an incomplete item is packed empty, which never verifies
+                    uint[] pubkey_lens = new uint[count];
+                    uint[] sig_lens = new uint[count];
+                    byte[] hashes = new byte[count * 64];
+                    int pubkeys_len = 0;
+                    int sigs_len = 0;
+                    using (var sha = new SHA512Managed())
+                    {
+                        for (int i = 0; i < count; i++)
+                        {
+                            if (inputs[i] == null || publicKeys[i] == null || signatures[i] == null)
+                            {
+                                continue;
+                            }
+                            Buffer.BlockCopy(sha.ComputeHash(inputs[i]), 0, hashes, i * 64, 64);
+                            pubkey_lens[i] = (uint)publicKeys[i].Length;
+                            sig_lens[i] = (uint)signatures[i].Length;
+                            pubkeys_len += publicKeys[i].Length;
+                            sigs_len += signatures[i].Length;
+                        }
+                    }
+                    byte[] pubkeys = new byte[pubkeys_len];
+                    byte[] sigs = new byte[sigs_len];
+                    pubkeys_len = 0;
+                    sigs_len = 0;
+                    for (int i = 0; i < count; i++)
+                    {
+                        if (pubkey_lens[i] > 0)
+                        {
+                            Buffer.BlockCopy(publicKeys[i], 0, pubkeys, pubkeys_len, (int)pubkey_lens[i]);
+                            pubkeys_len += (int)pubkey_lens[i];
+                        }
+                        if (sig_lens[i] > 0)
+                        {
+                            Buffer.BlockCopy(signatures[i], 0, sigs, sigs_len, (int)sig_lens[i]);
+                            sigs_len += (int)sig_lens[i];
+                        }
+                    }
+
+                    int[] native_results = new int[count];
+                    ix_rsa_verify_batch(pubkeys, pubkey_lens, hashes, sigs, sig_lens, count, native_results);
+                    for (int i = 0; i < count; i++)
+                    {
+                        if (native_results[i] == nativeKeyUnhandled)
+                        {
+                            results[i] = pubkey_lens[i] > 0 && verifySignatureManaged(inputs[i], publicKeys[i], signatures[i]);
+                        }
+                        else
+                        {
+                            results[i] = native_results[i] == 1;
+                        }
+                    }
+                    return results;
+                }
+                catch (DllNotFoundException)
+                {
+                    nativeRSA = false;
+                }
+                catch (EntryPointNotFoundException)
+                {
+                    nativeRSA = false;
+                }
+            }
+
+            for (int i = 0; i < count; i++)
+            {
+                results[i] = verifySignature(inputs[i], publicKeys[i], signatures[i]);
+            }
+            return results;
+        }
+
         // Encrypt data using RSA
         public byte[] encryptWithRSA(byte[] input, byte[] publicKey)
         {
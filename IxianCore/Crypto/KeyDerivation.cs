@@ -27,7 +27,6 @@ namespace IXICore.CryptoKey
             byte[] initialRandomState;
             byte[] currentRandomState;
             int currentIteration;
-            SHA512Managed sha;
             //
             public PRNG(byte[] random_state)
             {
@@ -41,20 +40,16 @@ namespace IXICore.CryptoKey
                 Array.Copy(random_state, initialRandomState, total_len);
                 Array.Copy(random_state, currentRandomState, total_len);
                 currentIteration = 0;
-                //
-                sha = new SHA512Managed();
-                sha.Initialize();
             }
 
-            private void twiddleRandomState()
+            [DllImport("IXICrypt.dll", CallingConvention = CallingConvention.Cdecl)]
+            static extern void ix_twiddle_state([In, Out] byte[] state, uint state_len, uint iterations);
+
+            // Replaces each 64-byte region by its SHA-512, iterations times; done natively, several regions at once
+            private void twiddleRandomState(int iterations = 1)
             {
-                int blocks = currentRandomState.Length / 64;
-                // each 64-byte region separately
-                for (int i = 0; i < blocks; i++)
-                {
-                    Array.Copy(sha.ComputeHash(currentRandomState, i * 64, 64), 0, currentRandomState, i * 64, 64);
-                }
-                currentIteration += 1;
+                ix_twiddle_state(currentRandomState, (uint)currentRandomState.Length, (uint)iterations);
+                currentIteration += iterations;
             }
 
             public void setIteration(int iteration)
@@ -69,9 +64,9 @@ namespace IXICore.CryptoKey
                     Array.Copy(initialRandomState, currentRandomState, initialRandomState.Length);
                     currentIteration = 0;
                 }
-                while(currentIteration < iteration)
+                if(currentIteration < iteration)
                 {
-                    twiddleRandomState();
+                    twiddleRandomState(iteration - currentIteration);
                 }
             }
 
@@ -79,6 +74,11 @@ namespace IXICore.CryptoKey
             {
                 return currentRandomState;
             }
+
+            public byte[] getInitialRandomState()
+            {
+                return initialRandomState;
+            }
         }
 
         [StructLayout(LayoutKind.Sequential)]
@@ -135,6 +135,12 @@ namespace IXICore.CryptoKey
         [DllImport("IXICrypt.dll", CallingConvention = CallingConvention.Cdecl)]
         static extern IntPtr ix_generate_rsa(IntPtr entropy, uint entropy_len, int key_size_bits, ulong pub_exponent);
 
+        [DllImport("IXICrypt.dll", CallingConvention = CallingConvention.Cdecl)]
+        static extern IntPtr ix_generate_rsa_v2(byte[] entropy, uint entropy_len, int key_size_bits, ulong pub_exponent);
+
+        [DllImport("IXICrypt.dll", CallingConvention = CallingConvention.Cdecl)]
+        static extern int ix_generate_rsa_many(byte[] entropy, uint entropy_len, int first_index, int count, int key_size_bits, ulong pub_exponent, [Out] IntPtr[] out_keys);
+
         [DllImport("IXICrypt.dll", CallingConvention = CallingConvention.Cdecl)]
         static extern void ix_free_key(IntPtr key);
 
@@ -158,6 +164,49 @@ namespace IXICore.CryptoKey
             return buildIxianKeyPair(returned_key);            
         }
 
+        // Key generation version 2: both primes are searched for at once on several cores. It derives a different
+        // key than deriveKey for the same index, so keys must always be re-derived with the version that made them.
+        public IxianKeyPair deriveKey_v2(int key_index, int key_length, ulong public_exponent)
+        {
+            RandomSource.setIteration(key_index);
+            byte[] entropy = RandomSource.getRandomState();
+            IntPtr c_rsa_key = ix_generate_rsa_v2(entropy, (uint)entropy.Length, key_length, public_exponent);
+            if (c_rsa_key == IntPtr.Zero)
+            {
+                return null;
+            }
+            IXI_RSA_KEY rsa_key = (IXI_RSA_KEY)Marshal.PtrToStructure(c_rsa_key, typeof(IXI_RSA_KEY));
+            byte[] returned_key = new byte[rsa_key.len];
+            Marshal.Copy(rsa_key.data, returned_key, 0, (int)rsa_key.len);
+            ix_free_key(c_rsa_key);
+            // returned_key is in pkcs #1 format
+            return buildIxianKeyPair(returned_key);
+        }
+
+        // Derives the keys for count consecutive indexes starting at first_index, as deriveKey would one by one.
+        // The entropy pool is advanced natively and the keys are generated in parallel. Failed keys are null.
+        public IxianKeyPair[] deriveKeys(int first_index, int count, int key_length, ulong public_exponent)
+        {
+            byte[] entropy = RandomSource.getInitialRandomState();
+            IntPtr[] c_rsa_keys = new IntPtr[count];
+            ix_generate_rsa_many(entropy, (uint)entropy.Length, first_index, count, key_length, public_exponent, c_rsa_keys);
+            IxianKeyPair[] key_pairs = new IxianKeyPair[count];
+            for (int i = 0; i < count; i++)
+            {
+                if (c_rsa_keys[i] == IntPtr.Zero)
+                {
+                    continue;
+                }
+                IXI_RSA_KEY rsa_key = (IXI_RSA_KEY)Marshal.PtrToStructure(c_rsa_keys[i], typeof(IXI_RSA_KEY));
+                byte[] returned_key = new byte[rsa_key.len];
+                Marshal.Copy(rsa_key.data, returned_key, 0, (int)rsa_key.len);
+                ix_free_key(c_rsa_keys[i]);
+                // returned_key is in pkcs #1 format
+                key_pairs[i] = buildIxianKeyPair(returned_key);
+            }
+            return key_pairs;
+        }
+
         public static byte[] getNewRandomSeed(int seed_len)
         {
             byte[] entropy = new byte[seed_len];
@@ -180,26 +229,32 @@ namespace IXICore.CryptoKey
             DLT.CryptoManager.initLib();
             Logging.info(String.Format("Starting key generation. Iterations: {0}", num_iterations));
             List<TimeSpan> generationTimes = new List<TimeSpan>();
-            for (int i = 0; i < num_iterations; i++)
+            // Keys are derived a core's worth at a time, so each is timed as its share of the batch
+            int batch_size = Environment.ProcessorCount;
+            for (int first = 0; first < num_iterations; first += batch_size)
             {
+                int count = Math.Min(batch_size, num_iterations - first);
                 DateTime start = DateTime.Now;
-                Logging.info(String.Format("Generating key {0}...", i));
-                IxianKeyPair kp = kd.deriveKey(i, key_size, 65537);
-                TimeSpan generationTime = DateTime.Now - start;
-                bool success = DLT.CryptoManager.lib.testKeys(Encoding.Unicode.GetBytes("TEST TEST"), kp);
-                double key_entropy = calculateBytestreamEntropy(kp.privateKeyBytes);
-                if (success && output != null)
+                Logging.info(String.Format("Generating keys {0} to {1}...", first, first + count - 1));
+                IxianKeyPair[] key_pairs = kd.deriveKeys(first, count, key_size, 65537);
+                TimeSpan generationTime = new TimeSpan((DateTime.Now - start).Ticks / count);
+                foreach (IxianKeyPair kp in key_pairs)
                 {
-                    RSACryptoServiceProvider rsaCSP = rsaKeyFromBytes(kp.privateKeyBytes);
-                    RSAParameters rsaP = rsaCSP.ExportParameters(true);
-                    BigInteger n = new BigInteger(rsaP.Modulus);
-                    output.WriteLine(String.Format("{0}|{1}", n.ToString(), key_entropy));
+                    bool success = kp != null && DLT.CryptoManager.lib.testKeys(Encoding.Unicode.GetBytes("TEST TEST"), kp);
+                    double key_entropy = kp != null ? calculateBytestreamEntropy(kp.privateKeyBytes) : 0;
+                    if (success && output != null)
+                    {
+                        RSACryptoServiceProvider rsaCSP = rsaKeyFromBytes(kp.privateKeyBytes);
+                        RSAParameters rsaP = rsaCSP.ExportParameters(true);
+                        BigInteger n = new BigInteger(rsaP.Modulus);
+                        output.WriteLine(String.Format("{0}|{1}", n.ToString(), key_entropy));
+                    }
+                    Logging.info(String.Format("Key generated. ({0:0.00} ms)",
+                        generationTime.TotalMilliseconds));
+                    generationTimes.Add(generationTime);
+                    Logging.info(String.Format("Key test: {0}", success ? "success" : "failure"));
+                    Logging.info(String.Format("Key entropy: {0}", key_entropy));
                 }
-                Logging.info(String.Format("Key generated. ({0:0.00} ms)",
-                    generationTime.TotalMilliseconds));
-                generationTimes.Add(generationTime);
-                Logging.info(String.Format("Key test: {0}", success ? "success" : "failure"));
-                Logging.info(String.Format("Key entropy: {0}", key_entropy));
             }
             if(output != null)
             {
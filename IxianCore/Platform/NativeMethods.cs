@@ -14,6 +14,63 @@ internal static class NativeMethods
                              IntPtr salt, UIntPtr salt_len,
                              IntPtr output, UIntPtr output_len);
 
+    // One piece of a password for argon2id_hash_raw_segments; data must point at pinned memory
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct Argon2Segment
+    {
+        public IntPtr data;
+        public UIntPtr len;
+    }
+
+    // Hashes the password made of segment_count segments, read back to back, without copying them or the salt
+    [DllImport("libargon2", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int argon2id_hash_raw_segments(UInt32 time_cost, UInt32 mem_cost, UInt32 parallelism,
+                             Argon2Segment[] segments, UIntPtr segment_count,
+                             byte[] salt, UIntPtr salt_len,
+                             [Out] byte[] output, UIntPtr output_len);
+
+    // Hashes one password with salt_count salts of salt_len bytes each, writing salt_count hashes of output_len bytes
+    [DllImport("libargon2", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int argon2id_hash_raw_batch(UInt32 time_cost, UInt32 mem_cost, UInt32 parallelism,
+                             byte[] data, UIntPtr data_len,
+                             byte[] salts, UIntPtr salt_len, UIntPtr salt_count,
+                             byte[] output, UIntPtr output_len, UInt32 threads);
+
+    // Returned by argon2id_pow_search when it was cancelled or ran out of time before finding a solution
+    internal const int ARGON2_POW_NOT_FOUND = -36;
+
+    // Runs the nonce search natively until a hash not above hash_ceil is found, cancel becomes non-zero or time_budget_ms passes.
+    // nonce holds the first nonce to try on input, and the solution (or the nonce to continue from) on return.
+    [DllImport("libargon2", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int argon2id_pow_search(UInt32 time_cost, UInt32 mem_cost, UInt32 parallelism,
+                             byte[] data, UIntPtr data_len,
+                             [In, Out] byte[] nonce, UIntPtr nonce_len,
+                             byte[] hash_ceil, UIntPtr hash_ceil_len,
+                             [Out] byte[] output, UIntPtr output_len,
+                             ref int cancel, UInt32 time_budget_ms,
+                             ref long hash_counter, UInt32 threads);
+
+    // Returned by argon2id_pow_verify_batch when at least one item failed
+    internal const int ARGON2_VERIFY_MISMATCH = -35;
+
+    // Checks count proof-of-work solutions across threads threads. challenges and nonces are concatenated, with per-item lengths;
+    // hash_ceils holds one hash_ceil_len ceiling per item. Bit i of results (byte i / 8) is set if item i passed.
+    [DllImport("libargon2", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int argon2id_pow_verify_batch(UInt32 time_cost, UInt32 mem_cost, UInt32 parallelism,
+                             byte[] challenges, UIntPtr[] challenge_lens,
+                             byte[] nonces, UIntPtr[] nonce_lens,
+                             byte[] hash_ceils, UIntPtr hash_ceil_len, UIntPtr count,
+                             UIntPtr output_len, [Out] byte[] results,
+                             UInt32 threads, UInt32 flags);
+
+    // Returns the fill_block kernel (argon2_kernel) libargon2 picked for this CPU, or the one forced with argon2_set_kernel
+    [DllImport("libargon2", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern int argon2_get_kernel();
+
+    // Returns a static string naming the kernel; it must not be freed
+    [DllImport("libargon2", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
+    internal static extern IntPtr argon2_kernel2string(int kernel);
+
     [DllImport("kernel32.dll", SetLastError = true)]
     internal static extern IntPtr GetStdHandle(int nStdHandle);
 
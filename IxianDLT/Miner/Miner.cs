@@ -33,6 +33,9 @@ namespace DLT
         public BlockSearchMode searchMode = BlockSearchMode.randomLowestDifficulty;
 
         private long hashesPerSecond = 0; // Total number of hashes per second
+        private int powSearchCancel = 0; // Non-zero interrupts running native nonce searches
+        private const uint powSearchTimeBudget = 250; // Maximum duration of a single native nonce search, in milliseconds
+        private const int powBatchSize_v1 = 16; // Number of nonces hashed per native call by calculatePow_v1
         private DateTime lastStatTime; // Last statistics output time
         private bool shouldStop = false; // flag to signal shutdown of threads
         private ThreadLiveCheck TLC;
@@ -65,8 +68,10 @@ namespace DLT
             // Calculate the allowed number of threads based on logical processor count
             Config.miningThreads = calculateMiningThreadsCount(Config.miningThreads);
             Logging.info(String.Format("Starting miner with {0} threads on {1} logical processors.", Config.miningThreads, Environment.ProcessorCount));
+            Logging.info(String.Format("Argon2 is using the {0} kernel.", Marshal.PtrToStringAnsi(NativeMethods.argon2_kernel2string(NativeMethods.argon2_get_kernel()))));
 
             shouldStop = false;
+            powSearchCancel = 0;
 
             TLC = new ThreadLiveCheck();
             // Start primary mining thread
@@ -89,6 +94,7 @@ namespace DLT
         public bool stop()
         {
             shouldStop = true;
+            powSearchCancel = 1;
             return true;
         }
 
@@ -542,20 +548,41 @@ namespace DLT
         private void calculatePow_v1(byte[] hash_ceil)
         {
             // PoW = Argon2id( BlockChecksum + SolverAddress, Nonce)
-            byte[] nonce = ASCIIEncoding.ASCII.GetBytes(ASCIIEncoding.ASCII.GetString(randomNonce(64)));
-            byte[] hash = findHash_v1(activeBlockChallenge, nonce);
-            if (hash.Length < 1)
+            // powBatchSize_v1 nonces are hashed in one libargon2 call, which absorbs the challenge only once
+            byte[] nonces = new byte[powBatchSize_v1 * 64];
+            for (int i = 0; i < powBatchSize_v1; i++)
             {
+                byte[] next_nonce = ASCIIEncoding.ASCII.GetBytes(ASCIIEncoding.ASCII.GetString(randomNonce(64)));
+                System.Buffer.BlockCopy(next_nonce, 0, nonces, i * 64, 64);
+            }
+            byte[] hashes = new byte[powBatchSize_v1 * 32];
+            int result = NativeMethods.argon2id_hash_raw_batch((UInt32)1, (UInt32)1024, (UInt32)2,
+                activeBlockChallenge, (UIntPtr)activeBlockChallenge.Length,
+                nonces, (UIntPtr)64, (UIntPtr)powBatchSize_v1,
+                hashes, (UIntPtr)32, (UInt32)2);
+            if (result != 0)
+            {
+                Logging.error(string.Format("Error during mining: argon2 returned {0}", result));
                 Logging.error("Stopping miner due to invalid hash.");
                 stop();
                 return;
             }
 
-            hashesPerSecond++;
+            hashesPerSecond += powBatchSize_v1;
 
-            // We have a valid hash, update the corresponding block
-            if (Miner.validateHashInternal_v1(hash, hash_ceil) == true)
+            for (int i = 0; i < powBatchSize_v1; i++)
             {
+                byte[] hash = new byte[32];
+                System.Buffer.BlockCopy(hashes, i * 32, hash, 0, 32);
+                if (Miner.validateHashInternal_v1(hash, hash_ceil) == false)
+                {
+                    continue;
+                }
+
+                byte[] nonce = new byte[64];
+                System.Buffer.BlockCopy(nonces, i * 64, nonce, 0, 64);
+
+                // We have a valid hash, update the corresponding block
                 Logging.info(String.Format("SOLUTION FOUND FOR BLOCK #{0}", activeBlock.blockNum));
 
                 // Broadcast the nonce to the network
@@ -573,23 +600,34 @@ namespace DLT
 
                 // Reset the block found flag so we can search for another block
                 blockFound = false;
+                return;
             }
         }
 
         private void calculatePow_v2(byte[] hash_ceil)
         {
             // PoW = Argon2id( BlockChecksum + SolverAddress, Nonce)
+            // The nonce loop runs inside libargon2 and counts into hashesPerSecond. It returns after powSearchTimeBudget
+            // at the latest, so that block selection and stats keep being refreshed.
             byte[] nonce = randomNonce(64);
-            byte[] hash = findHash_v1(activeBlockChallenge, nonce);
-            if (hash.Length < 1)
+            byte[] hash = new byte[32];
+            int result = NativeMethods.argon2id_pow_search((UInt32)1, (UInt32)1024, (UInt32)2,
+                activeBlockChallenge, (UIntPtr)activeBlockChallenge.Length,
+                nonce, (UIntPtr)nonce.Length,
+                hash_ceil, (UIntPtr)hash_ceil.Length,
+                hash, (UIntPtr)hash.Length,
+                ref powSearchCancel, powSearchTimeBudget, ref hashesPerSecond, (UInt32)2);
+            if (result == NativeMethods.ARGON2_POW_NOT_FOUND)
+            {
+                return;
+            }
+            if (result != 0)
             {
                 Logging.error("Stopping miner due to invalid hash.");
                 stop();
                 return;
             }
 
-            hashesPerSecond++;
-
             // We have a valid hash, update the corresponding block
             if (Miner.validateHashInternal_v2(hash, hash_ceil) == true)
             {
@@ -719,12 +757,9 @@ namespace DLT
 
             // TODO checksum the solver_address just in case it's not valid
             // also protect against spamming with invalid nonce/block_num
-            Byte[] p1 = new Byte[block.blockChecksum.Length + solver_address.Length];
-            System.Buffer.BlockCopy(block.blockChecksum, 0, p1, 0, block.blockChecksum.Length);
-            System.Buffer.BlockCopy(solver_address, 0, p1, block.blockChecksum.Length, solver_address.Length);
 
             byte[] nonce_bytes = ASCIIEncoding.ASCII.GetBytes(nonce);
-            string hash = Miner.findHash_v0(p1, nonce_bytes);
+            string hash = Miner.findHash_v0(block.blockChecksum, solver_address, nonce_bytes);
 
             if (Miner.validateHash_v0(hash, difficulty) == true)
             {
@@ -749,12 +784,9 @@ namespace DLT
 
             // TODO checksum the solver_address just in case it's not valid
             // also protect against spamming with invalid nonce/block_num
-            byte[] p1 = new byte[block.blockChecksum.Length + solver_address.Length];
-            System.Buffer.BlockCopy(block.blockChecksum, 0, p1, 0, block.blockChecksum.Length);
-            System.Buffer.BlockCopy(solver_address, 0, p1, block.blockChecksum.Length, solver_address.Length);
 
             byte[] nonce_bytes = ASCIIEncoding.ASCII.GetBytes(nonce);
-            byte[] hash = Miner.findHash_v1(p1, nonce_bytes);
+            byte[] hash = Miner.findHash_v1(block.blockChecksum, solver_address, nonce_bytes);
 
             if (Miner.validateHash_v1(hash, difficulty) == true)
             {
@@ -779,12 +811,9 @@ namespace DLT
 
             // TODO checksum the solver_address just in case it's not valid
             // also protect against spamming with invalid nonce/block_num
-            byte[] p1 = new byte[block.blockChecksum.Length + solver_address.Length];
-            System.Buffer.BlockCopy(block.blockChecksum, 0, p1, 0, block.blockChecksum.Length);
-            System.Buffer.BlockCopy(solver_address, 0, p1, block.blockChecksum.Length, solver_address.Length);
 
             byte[] nonce_bytes = Crypto.stringToHash(nonce);
-            byte[] hash = Miner.findHash_v1(p1, nonce_bytes);
+            byte[] hash = Miner.findHash_v1(block.blockChecksum, solver_address, nonce_bytes);
 
             if (Miner.validateHash_v2(hash, difficulty) == true)
             {
@@ -795,6 +824,73 @@ namespace DLT
             return false;
         }
 
+        // Verify many v2 nonces at once, spread over all logical processors
+        // Each solution is an object[4] { string nonce, ulong block_num, byte[] solver_address, ulong difficulty }
+        // Returns one result per solution, the same verifyNonce_v2 would give
+        public static bool[] verifyNonces_v2(List<object[]> solutions)
+        {
+            bool[] results = new bool[solutions.Count];
+            List<int> indexes = new List<int>();
+            List<byte> challenges = new List<byte>();
+            List<UIntPtr> challenge_lens = new List<UIntPtr>();
+            List<byte> nonces = new List<byte>();
+            List<UIntPtr> nonce_lens = new List<UIntPtr>();
+            List<byte> hash_ceils = new List<byte>();
+
+            for (int i = 0; i < solutions.Count; i++)
+            {
+                string nonce = (string)solutions[i][0];
+                if (nonce == null || nonce.Length < 1 || nonce.Length > 128)
+                {
+                    continue;
+                }
+
+                Block block = Node.blockChain.getBlock((ulong)solutions[i][1], false, false);
+                if (block == null)
+                    continue;
+
+                byte[] nonce_bytes = null;
+                try
+                {
+                    nonce_bytes = Crypto.stringToHash(nonce);
+                }
+                catch (Exception)
+                {
+                    continue;
+                }
+
+                byte[] solver_address = (byte[])solutions[i][2];
+                challenges.AddRange(block.blockChecksum);
+                challenges.AddRange(solver_address);
+                challenge_lens.Add((UIntPtr)(block.blockChecksum.Length + solver_address.Length));
+                nonces.AddRange(nonce_bytes);
+                nonce_lens.Add((UIntPtr)nonce_bytes.Length);
+                hash_ceils.AddRange(getHashCeilFromDifficulty((ulong)solutions[i][3]));
+                indexes.Add(i);
+            }
+
+            if (indexes.Count == 0)
+            {
+                return results;
+            }
+
+            byte[] passed = new byte[(indexes.Count + 7) / 8];
+            int result = NativeMethods.argon2id_pow_verify_batch(1, 1024, 2, challenges.ToArray(), challenge_lens.ToArray(),
+                nonces.ToArray(), nonce_lens.ToArray(), hash_ceils.ToArray(), (UIntPtr)10, (UIntPtr)indexes.Count,
+                (UIntPtr)32, passed, (uint)Environment.ProcessorCount, 0);
+            if (result != 0 && result != NativeMethods.ARGON2_VERIFY_MISMATCH)
+            {
+                Logging.error(string.Format("Error during batch nonce verification: {0}", result));
+                return results;
+            }
+
+            for (int i = 0; i < indexes.Count; i++)
+            {
+                results[indexes[i]] = (passed[i / 8] & (1 << (i % 8))) != 0;
+            }
+            return results;
+        }
+
         // Submit solution with a provided blocknum
         // This is normally called from the API, as it is a static function
         public static bool sendSolution(byte[] nonce, ulong blocknum)
@@ -878,25 +974,57 @@ namespace DLT
             }
         }
 
+        // Hashes the concatenation of data with salt using Argon2id, without copying either; returns null on failure
+        private static byte[] argon2idHash(UInt32 parallelism, byte[] salt, params byte[][] data)
+        {
+            GCHandle[] handles = new GCHandle[data.Length];
+            try
+            {
+                NativeMethods.Argon2Segment[] segments = new NativeMethods.Argon2Segment[data.Length];
+                for (int i = 0; i < data.Length; i++)
+                {
+                    handles[i] = GCHandle.Alloc(data[i], GCHandleType.Pinned);
+                    segments[i].data = handles[i].AddrOfPinnedObject();
+                    segments[i].len = (UIntPtr)data[i].Length;
+                }
+                byte[] hash = new byte[32];
+                int result = NativeMethods.argon2id_hash_raw_segments((UInt32)1, (UInt32)1024, parallelism, segments, (UIntPtr)segments.Length,
+                    salt, (UIntPtr)salt.Length, hash, (UIntPtr)hash.Length);
+                if (result != 0)
+                {
+                    Logging.error(string.Format("Error during mining: argon2 returned {0}", result));
+                    return null;
+                }
+                return hash;
+            }
+            finally
+            {
+                foreach (GCHandle handle in handles)
+                {
+                    if (handle.IsAllocated)
+                    {
+                        handle.Free();
+                    }
+                }
+            }
+        }
+
         private static string findHash_v0(byte[] data, byte[] salt)
+        {
+            return findHash_v0(data, null, salt);
+        }
+
+        // Hashes data followed by data2 (if not null) as the password, without joining them
+        private static string findHash_v0(byte[] data, byte[] data2, byte[] salt)
         {
             string ret = "";
             try
             {
-                byte[] hash = new byte[32];
-                IntPtr data_ptr = Marshal.AllocHGlobal(data.Length);
-                IntPtr salt_ptr = Marshal.AllocHGlobal(salt.Length);
-                Marshal.Copy(data, 0, data_ptr, data.Length);
-                Marshal.Copy(salt, 0, salt_ptr, salt.Length);
-                UIntPtr data_len = (UIntPtr)data.Length;
-                UIntPtr salt_len = (UIntPtr)salt.Length;
-                IntPtr result_ptr = Marshal.AllocHGlobal(32);
-                int result = NativeMethods.argon2id_hash_raw((UInt32)1, (UInt32)1024, (UInt32)4, data_ptr, data_len, salt_ptr, salt_len, result_ptr, (UIntPtr)32);
-                Marshal.Copy(result_ptr, hash, 0, 32);
-                ret = BitConverter.ToString(hash).Replace("-", string.Empty);
-                Marshal.FreeHGlobal(data_ptr);
-                Marshal.FreeHGlobal(result_ptr);
-                Marshal.FreeHGlobal(salt_ptr);
+                byte[] hash = data2 == null ? argon2idHash(4, salt, data) : argon2idHash(4, salt, data, data2);
+                if (hash != null)
+                {
+                    ret = BitConverter.ToString(hash).Replace("-", string.Empty);
+                }
             }
             catch (Exception e)
             {
@@ -906,23 +1034,16 @@ namespace DLT
         }
 
         private static byte[] findHash_v1(byte[] data, byte[] salt)
+        {
+            return findHash_v1(data, null, salt);
+        }
+
+        // Hashes data followed by data2 (if not null) as the password, without joining them
+        private static byte[] findHash_v1(byte[] data, byte[] data2, byte[] salt)
         {
             try
             {
-                byte[] hash = new byte[32];
-                IntPtr data_ptr = Marshal.AllocHGlobal(data.Length);
-                IntPtr salt_ptr = Marshal.AllocHGlobal(salt.Length);
-                Marshal.Copy(data, 0, data_ptr, data.Length);
-                Marshal.Copy(salt, 0, salt_ptr, salt.Length);
-                UIntPtr data_len = (UIntPtr)data.Length;
-                UIntPtr salt_len = (UIntPtr)salt.Length;
-                IntPtr result_ptr = Marshal.AllocHGlobal(32);
-                int result = NativeMethods.argon2id_hash_raw((UInt32)1, (UInt32)1024, (UInt32)2, data_ptr, data_len, salt_ptr, salt_len, result_ptr, (UIntPtr)32);
-                Marshal.Copy(result_ptr, hash, 0, 32);
-                Marshal.FreeHGlobal(data_ptr);
-                Marshal.FreeHGlobal(result_ptr);
-                Marshal.FreeHGlobal(salt_ptr);
-                return hash;
+                return data2 == null ? argon2idHash(2, salt, data) : argon2idHash(2, salt, data, data2);
             }
             catch(Exception e)
             {
@@ -1120,6 +1120,77 @@ namespace DLT
             return false;
         }
 
+        // Verify the nonces of all v2+ PoW solutions in a block in one parallel batch
+        // Returns the ids of the solutions that passed; the others still go through the full check in verifyPoWTransaction
+        private static HashSet<string> verifyPoWNoncesFromBlock(Block block)
+        {
+            HashSet<string> verified_txids = new HashSet<string>();
+            List<object[]> solutions = new List<object[]>();
+            List<string> txids = new List<string>();
+
+            foreach (string txid in block.transactions)
+            {
+                if (txid.StartsWith("stk"))
+                {
+                    continue;
+                }
+
+                Transaction tx = getTransaction(txid, block.blockNum);
+                if (tx == null || tx.type != (int)Transaction.Type.PoWSolution)
+                {
+                    continue;
+                }
+
+                if (tx.fromLocalStorage && !Config.fullStorageDataVerification)
+                {
+                    continue;
+                }
+
+                try
+                {
+                    ulong pow_block_num = 0;
+                    string nonce = "";
+                    using (MemoryStream m = new MemoryStream(tx.data))
+                    {
+                        using (BinaryReader reader = new BinaryReader(m))
+                        {
+                            pow_block_num = reader.ReadUInt64();
+                            nonce = reader.ReadString();
+                        }
+                    }
+
+                    Block pow_block = Node.blockChain.getBlock(pow_block_num);
+                    if (pow_block == null || pow_block.version < 2)
+                    {
+                        continue;
+                    }
+
+                    solutions.Add(new object[4] { nonce, pow_block_num, (new Address(tx.pubKey)).address, pow_block.difficulty });
+                    txids.Add(txid);
+                }
+                catch (Exception e)
+                {
+                    Logging.warn(string.Format("Error reading PoW Transaction: {0}. Message: {1}", tx.id, e.Message));
+                }
+            }
+
+            // A single solution gains nothing from batching
+            if (solutions.Count < 2)
+            {
+                return verified_txids;
+            }
+
+            bool[] results = Miner.verifyNonces_v2(solutions);
+            for (int i = 0; i < results.Length; i++)
+            {
+                if (results[i])
+                {
+                    verified_txids.Add(txids[i]);
+                }
+            }
+            return verified_txids;
+        }
+
         public static bool setAppliedFlagToTransactionsFromBlock(Block b)
         {
             if (b == null)
@@ -1285,6 +1356,8 @@ namespace DLT
                     return false;
                 }
 
+                HashSet<string> verified_pow_txids = verifyPoWNoncesFromBlock(block);
+
 
                 foreach (string txid in block.transactions)
                 {
@@ -1351,7 +1424,7 @@ namespace DLT
                     }
 
                     // Special case for PoWSolution transactions
-                    if (applyPowTransaction(tx, block, blockSolutionsDictionary, failed_transactions, ws_snapshot))
+                    if (applyPowTransaction(tx, block, blockSolutionsDictionary, failed_transactions, ws_snapshot, !verified_pow_txids.Contains(txid)))
                     {
                         continue;
                     }
@@ -284,6 +284,16 @@ namespace CryptoLibs
             return false;
         }
 
+        public bool[] verifySignatures(byte[][] inputs, byte[][] publicKeys, byte[][] signatures)
+        {
+            bool[] results = new bool[inputs.Length];
+            for (int i = 0; i < inputs.Length; i++)
+            {
+                results[i] = verifySignature(inputs[i], publicKeys[i], signatures[i]);
+            }
+            return results;
+        }
+
         // Encrypt data using RSA
         public byte[] encryptWithRSA(byte[] input, byte[] publicKey)
         {